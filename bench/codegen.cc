@@ -0,0 +1,144 @@
+#include "../src/vm/machine.hh"
+#include "../src/vm/world.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// code quality of the compiler: compiles every spell of a corpus at each -O level, runs it on the
+//  reference VM in a fixed world and checks what it did against the spell's expected transcript;
+//  the metrics are compared with a checked-in baseline, see usage below
+
+namespace fs = std::filesystem;
+
+struct Metrics {
+    size_t executed = 0;    // instructions run
+    size_t size = 0;        // instructions in the program, labels included
+    size_t slots = reservedRegisters;   // slots the program refers to, SELF and TARGET included
+};
+
+std::optional<std::string> readFile(const fs::path &path) {
+    std::ifstream file(path);
+    if (!file) return std::nullopt;
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// lines of `<spell> <level> <executed> <size> <slots>`
+std::map<std::pair<std::string, int>, Metrics> readBaseline(const std::string &text) {
+    std::map<std::pair<std::string, int>, Metrics> baseline;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream words(line);
+        std::string spell;
+        int level;
+        Metrics metrics;
+        if (words >> spell >> level >> metrics.executed >> metrics.size >> metrics.slots) baseline[{spell, level}] = metrics;
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    std::string executable = argv[0];
+    std::vector<std::string> arguments;
+    bool update = false;
+    size_t threshold = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        if (str == "--update") {
+            update = true;
+        } else if (str.rfind("--threshold=", 0) == 0) {
+            auto value = str.substr(str.find('=') + 1);
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << executable << ": invalid percentage in `" << str << "`\n";
+                return 1;
+            }
+            threshold = std::stoul(value);
+        } else {
+            arguments.push_back(str);
+        }
+    }
+    if (arguments.size() != 3) {
+        std::cerr << "usage: " << executable << " compiler corpus outdir [--threshold=PERCENT] [--update]\n"
+                  << "  runs every corpus/*.s20 at -O0, -O1 and -O2 in corpus/world.txt, checks its transcript against\n"
+                  << "  the .expected file next to it and its metrics against corpus/baseline.txt (--update rewrites it)\n";
+        return 1;
+    }
+    auto compiler = arguments[0];
+    fs::path corpus = arguments[1], outdir = arguments[2];
+    fs::create_directories(outdir);
+
+    auto script = readFile(corpus / "world.txt");
+    if (!script || std::holds_alternative<WorldScriptError>(loadWorldScript(*script))) {
+        std::cerr << executable << ": cannot load " << (corpus / "world.txt").string() << "\n";
+        return 1;
+    }
+    auto baseline = readBaseline(readFile(corpus / "baseline.txt").value_or(""));
+
+    std::vector<fs::path> spells;
+    for (auto &entry: fs::directory_iterator(corpus)) {
+        if (entry.path().extension() == ".s20") spells.push_back(entry.path());
+    }
+    std::sort(spells.begin(), spells.end());
+
+    bool failed = false;
+    std::ostringstream updated;
+    updated << "# spell level executed size slots, written by bench-codegen --update\n";
+    std::cout << std::left << std::setw(12) << "spell" << std::right << std::setw(6) << "level" << std::setw(10) << "executed"
+              << std::setw(8) << "size" << std::setw(7) << "slots" << "  result\n";
+    for (auto &spell: spells) {
+        auto name = spell.stem().string();
+        auto expected = readFile(fs::path(spell).replace_extension(".expected"));
+        for (int level = 0; level <= 2; level++) {
+            auto output = outdir / (name + ".O" + std::to_string(level));
+            auto command = compiler + " -O" + std::to_string(level) + " " + spell.string() + " -o " + output.string() + " > /dev/null";
+            std::string result;
+            Metrics metrics;
+            auto text = std::system(command.c_str()) == 0 ? readFile(output) : std::nullopt;
+            auto program = text ? loadProgram(*text) : std::variant<IR, ProgramError>(ProgramError{0, ""});
+            if (std::holds_alternative<ProgramError>(program)) {
+                result = "does not compile";
+            } else {
+                auto &ir = std::get<IR>(program);
+                auto world = std::get<ScriptedWorld>(loadWorldScript(*script));
+                auto execution = execute(ir, world, 10000000);
+                std::string transcript;
+                for (auto &event: world.transcript) transcript += event + "\n";
+                if (execution.abort) transcript += "abort " + *execution.abort + "\n";
+                metrics.executed = execution.stats.instructions;
+                metrics.size = ir.instructions.size();
+                for (auto &ins: ir.instructions) {
+                    visitVReg(ins, [&](const VReg &r) { metrics.slots = std::max(metrics.slots, r + 1); },
+                                   [&](const VReg &r) { metrics.slots = std::max(metrics.slots, r + 1); });
+                }
+
+                if (!expected) result = "no " + name + ".expected";
+                else if (transcript != *expected) result = "wrong output";
+                auto old = baseline.find({name, level});
+                if (result.empty() && old != baseline.end()) {
+                    auto regressed = [&](size_t now, size_t before) { return now * 100 > before * (100 + threshold); };
+                    if (regressed(metrics.executed, old->second.executed)) result = "executed regressed from " + std::to_string(old->second.executed);
+                    else if (regressed(metrics.size, old->second.size)) result = "size regressed from " + std::to_string(old->second.size);
+                    else if (regressed(metrics.slots, old->second.slots)) result = "slots regressed from " + std::to_string(old->second.slots);
+                }
+                updated << name << " " << level << " " << metrics.executed << " " << metrics.size << " " << metrics.slots << "\n";
+            }
+            if (!result.empty() && !(update && result.find("regressed") != std::string::npos)) failed = true;
+            std::cout << std::left << std::setw(12) << name << std::right << std::setw(6) << ("-O" + std::to_string(level))
+                      << std::setw(10) << metrics.executed << std::setw(8) << metrics.size << std::setw(7) << metrics.slots
+                      << "  " << (result.empty() ? "ok" : result) << "\n";
+        }
+    }
+    if (update) {
+        std::ofstream(corpus / "baseline.txt") << updated.str();
+    }
+    return failed;
+}
@@ -0,0 +1,125 @@
+#include <std20c/compilation.hh>
+#include <std20c/language.hh>
+#include "../src/scan/tokenize.hh"
+#include "../src/parse/parser.hh"
+#include "../src/analysis/semantics.hh"
+#include "../src/codegen/emit.hh"
+#include "../src/document.hh"
+#include "../src/pipeline.hh"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// incremental front end: types a statement one character at a time into a generated program at several
+//  places, then deletes it again, timing Document::edit and check against scanning, parsing and checking
+//  the whole text, and checks every result against compileIR on the text
+
+// `lines` short statements, with a while of `block` statements in the middle
+std::string program(size_t lines, size_t block) {
+    std::string code = "Number x = 1;\n";
+    for (size_t i = 0; i < lines / 2; i++) code += "x = x * 3 + " + std::to_string(i) + ";\n";
+    code += "while (x > 0) {\n";
+    for (size_t i = 0; i < block; i++) code += "    x = x - " + std::to_string(i + 1) + ";\n";
+    code += "}\n";
+    for (size_t i = lines / 2; i < lines; i++) code += "if (x < " + std::to_string(i) + ") { x = x + 1; } else { x = 2; }\n";
+    return code + "print(x);\n";
+}
+
+// an error as its offset and message, or the program text of the IR
+std::string outcome(const std::variant<IR, CompilerError> &result, const std::string &code) {
+    if (std::holds_alternative<IR>(result)) {
+        std::string text;
+        emitIR(std::get<IR>(result), text);
+        return text;
+    }
+    auto &error = std::get<CompilerError>(result);
+    return "error at " + std::to_string(error.errorPosition - code.data()) + ": " + error.errorMessage;
+}
+std::string outcome(const std::optional<CompilerError> &error, const std::string &code) {
+    if (!error) return "";
+    return "error at " + std::to_string(error->errorPosition - code.data()) + ": " + error->errorMessage;
+}
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    const std::string typed = "x = x + 7;\n";
+
+    auto code = program(5000, 200);
+    Document document(code);
+    // at the start, in the first half, inside the while, in the second half, at the end
+    auto inBlock = code.find("while");
+    std::vector<size_t> places {0, code.size() / 4, inBlock + 40, code.size() * 3 / 4, code.size()};
+    for (auto &place: places) {
+        if (place > 0) place = code.rfind('\n', place - 1) + 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(3) << "incremental (" << code.size() << " bytes, "
+              << document.statements() << " top-level statements, ms per edit)\n";
+    std::cout << std::setw(9) << "offset" << std::setw(10) << "edits" << std::setw(12) << "reparsed"
+              << std::setw(14) << "incremental" << std::setw(12) << "full" << "\n";
+    bool ok = true;
+    for (auto place: places) {
+        double incremental = 0, full = 0;
+        size_t edits = 0, reparsed = 0;
+        auto step = [&](size_t offset, size_t length, std::string_view text) {
+            auto start = Clock::now();
+            document.edit(offset, length, text);
+            auto error = document.check();
+            incremental += seconds(start);
+            reparsed += document.reparsed();
+            edits++;
+
+            auto &current = document.text();
+            start = Clock::now();
+            {
+                ArenaScope arena;
+                auto tryScan = maximalMunch(current);
+                if (std::holds_alternative<std::vector<Token>>(tryScan)) {
+                    auto tryParse = earleyParser(std::get<std::vector<Token>>(tryScan));
+                    if (std::holds_alternative<Tree>(tryParse)) generateSymbolTable(std::get<Tree>(tryParse));
+                }
+            }
+            full += seconds(start);
+
+            ArenaScope arena;
+            auto expected = compileIR(current, 0, UnrollCostModel());
+            auto expectedError = std::holds_alternative<CompilerError>(expected)
+                ? outcome(expected, current) : std::string();
+            if (outcome(error, current) != expectedError) {
+                std::cout << "  after editing at " << offset << ": check() says `" << outcome(error, current)
+                          << "`, compileIR `" << expectedError << "`\n";
+                ok = false;
+            } else if (!error && outcome(document.compile(0, UnrollCostModel()), current) != outcome(expected, current)) {
+                std::cout << "  after editing at " << offset << ": compile() differs from compileIR\n";
+                ok = false;
+            }
+        };
+        for (size_t i = 0; i < typed.size(); i++) step(place + i, 0, typed.substr(i, 1));
+        for (size_t i = typed.size(); i-- > 0;) step(place + i, 1, "");
+        if (document.text() != code) {
+            std::cout << "  typing and deleting at " << place << " did not restore the text\n";
+            ok = false;
+        }
+        std::cout << std::setw(9) << place << std::setw(10) << edits << std::setw(12) << std::setprecision(1)
+                  << static_cast<double>(reparsed) / edits << std::setprecision(3) << std::setw(14)
+                  << incremental / edits * 1e3 << std::setw(12) << full / edits * 1e3 << "\n";
+    }
+
+    // replacing the whole text by another re-scans only what differs
+    auto changed = code;
+    changed.replace(code.find("x * 3 + 100;"), 12, "x * 4 + 100;");
+    auto start = Clock::now();
+    document.update(changed);
+    auto updated = seconds(start);
+    if (outcome(document.compile(0, UnrollCostModel()), document.text()) != outcome(compileIR(changed, 0, UnrollCostModel()), changed)) {
+        std::cout << "  update() differs from compileIR\n";
+        ok = false;
+    }
+    std::cout << "update of one statement: " << document.reparsed() << " reparsed, " << updated * 1e3 << " ms\n";
+    std::cout << (ok ? "ok" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+#include <std20c/compilation.hh>
+#include <std20c/language.hh>
+#include "../src/scan/tokenize.hh"
+#include "../src/scan/trivia.hh"
+#include "../src/parse/parser.hh"
+#include "../src/analysis/semantics.hh"
+#include "../src/codegen/lower.hh"
+#include "../src/optimization/optimizer.hh"
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// compiler throughput: generates valid programs of growing size in several shapes, times every phase
+//  over repeated runs and prints how each phase scales, so superlinear phases stand out; with
+//  --max-exponent it fails when one does, so a pass that turns quadratic is caught. With --parse-threads it
+//  also times -fparallel-parse on the largest program at 1, 2, 4, ... threads against the serial parser
+
+// a program of the given shape whose size grows linearly with n
+const std::map<std::string, std::function<std::string(size_t)>> shapes {
+    // many short statements on one variable
+    {"statements", [](size_t n) {
+        std::string code = "Number x = 1;\n";
+        for (size_t i = 0; i < n; i++) code += "x = x * 3 + " + std::to_string(i) + ";\n";
+        return code + "print(x);\n";
+    }},
+    // ifs and whiles nested n deep
+    {"nesting", [](size_t n) {
+        std::string code = "Number x = 0;\n";
+        for (size_t i = 0; i < n; i++) {
+            code += i % 2 ? "if (x < " + std::to_string(i) + ") {\n" : "while (x < " + std::to_string(i) + ") {\n";
+            code += "x = x + 1;\n";
+        }
+        for (size_t i = 0; i < n; i++) code += "}\n";
+        return code + "print(x);\n";
+    }},
+    // one expression with n operators
+    {"expressions", [](size_t n) {
+        const char *operators[] = {" + ", " * ", " - ", " / "};
+        std::string code = "Number y = 2;\nNumber x = 1";
+        for (size_t i = 0; i < n; i++) {
+            code += operators[i % 4];
+            code += i % 3 ? std::to_string(i + 1) : "(y + " + std::to_string(i) + ")";
+        }
+        return code + ";\nprint(x);\n";
+    }},
+    // builtin calls nested n deep, every level passing its arguments as expressions
+    //  (builtins have fixed arities, so long argument lists become long chains of arguments)
+    {"calls", [](size_t n) {
+        std::string code = "Vector v = ";
+        for (size_t i = 0; i < n; i++) code += "vadd(makevec(" + std::to_string(i) + ", 1 + 2, 3 * 4), ";
+        code += "entpos(SELF)";
+        for (size_t i = 0; i < n; i++) code += ")";
+        return code + ";\naccelent(SELF, v);\n";
+    }},
+    // indented statements with comments and string literals, so most bytes are whitespace and comments
+    {"trivia", [](size_t n) {
+        std::string code = "String s = \"\";\nNumber x = 0;\nwhile (x < 1) {\n";
+        for (size_t i = 0; i < n; i++) {
+            code += "        // step " + std::to_string(i) + ": neither this comment nor the indentation becomes a token\n";
+            code += "        s = sconcat(s, \"a string literal of some length, number " + std::to_string(i) + "\");    // appended\n\n";
+        }
+        return code + "        x = x + 1;\n}\nprint(s);\n";
+    }},
+    // a long spell: variables, branches, short counted loops, world queries and prints, in turn
+    {"spell", [](size_t n) {
+        std::string code = "Number x = 0;\nVector p = entpos(SELF);\n";
+        for (size_t i = 0; i < n; i++) {
+            auto v = "v" + std::to_string(i);
+            switch (i % 4) {
+            case 0: code += "Number " + v + " = x * 2 + " + std::to_string(i) + ";\n"; break;
+            case 1: code += "if (x > " + std::to_string(i) + ") { x = x - 1; } else { p = vadd(p, makevec(1, 0, 0)); }\n"; break;
+            case 2: code += "Number " + v + " = 0;\nwhile (" + v + " < 3) { x = x + " + v + "; " + v + " = " + v + " + 1; }\n"; break;
+            case 3: code += "print(sconcat(\"x is \", sify(x + vx(p))));\n"; break;
+            }
+        }
+        return code + "accelent(SELF, p);\n";
+    }},
+    // n variables, each computed from the ones before
+    {"variables", [](size_t n) {
+        std::string code = "Number v0 = 1;\n";
+        for (size_t i = 1; i < n; i++) {
+            code += "Number v" + std::to_string(i) + " = v" + std::to_string(i - 1) + " + v" + std::to_string(i / 2) + ";\n";
+        }
+        return code + "print(v" + std::to_string(n - 1) + ");\n";
+    }},
+};
+
+const std::vector<std::string> phases {"lex", "parse", "semantics", "lower", "optimize"};
+
+size_t countNodes(const Tree &tree) {
+    if (std::holds_alternative<Token>(tree)) return 1;
+    size_t nodes = 1;
+    for (auto &subtree: std::get<Branch>(tree).subtrees) nodes += countNodes(subtree);
+    return nodes;
+}
+
+struct Sample {
+    size_t size;
+    size_t tokens = 0, nodes = 0, instructions = 0;
+    std::map<std::string, std::vector<double>> seconds;    // per phase, one per run
+};
+
+double mean(const std::vector<double> &values) {
+    double sum = 0;
+    for (auto v: values) sum += v;
+    return sum / values.size();
+}
+double deviation(const std::vector<double> &values) {
+    auto m = mean(values);
+    double sum = 0;
+    for (auto v: values) sum += (v - m) * (v - m);
+    return values.size() > 1 ? std::sqrt(sum / (values.size() - 1)) : 0;
+}
+
+// one compilation of the program with every phase timed; false if the program does not compile
+bool measure(const std::string &code, size_t level, Sample &sample) {
+    ArenaScope arena;
+    using Clock = std::chrono::steady_clock;
+    auto time = [&](const std::string &phase, auto &&run) {
+        auto start = Clock::now();
+        auto result = run();
+        sample.seconds[phase].push_back(std::chrono::duration<double>(Clock::now() - start).count());
+        return result;
+    };
+    auto tryScan = time("lex", [&] { return maximalMunch(code); });
+    if (!std::holds_alternative<std::vector<Token>>(tryScan)) return false;
+    auto &tokens = std::get<std::vector<Token>>(tryScan);
+    auto tryParse = time("parse", [&] { return earleyParser(tokens); });
+    if (!std::holds_alternative<Tree>(tryParse)) return false;
+    auto &tree = std::get<Tree>(tryParse);
+    auto tryAnalyze = time("semantics", [&] { return generateSymbolTable(tree); });
+    if (!std::holds_alternative<SymbolTable>(tryAnalyze)) return false;
+    auto ir = time("lower", [&] { return generateIR(std::get<SymbolTable>(tryAnalyze), tree); });
+    auto optimized = time("optimize", [&] { return level ? optimizer(ir, level, UnrollCostModel()) : ir; });
+
+    sample.tokens = tokens.size();
+    sample.nodes = countNodes(tree);
+    sample.instructions = ir.instructions.size();
+    return true;
+}
+
+// mean seconds parsing `code` takes over `runs` runs, with parallelEarleyParser on `threads` threads or
+//  earleyParser if 0
+double timeParse(const std::string &code, size_t threads, size_t runs) {
+    ArenaScope arena;
+    auto tokens = std::get<std::vector<Token>>(maximalMunch(code));
+    std::vector<double> seconds;
+    for (size_t run = 0; run < runs; run++) {
+        ArenaScope parse;
+        auto start = std::chrono::steady_clock::now();
+        auto tree = threads ? parallelEarleyParser(tokens, threads) : earleyParser(tokens);
+        seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return mean(seconds);
+}
+
+int main(int argc, char* argv[]) {
+    std::string executable = argv[0];
+    std::vector<std::string> selected;
+    size_t size = 16, steps = 4, runs = 3, level = 2, parseThreads = 0;
+    double maxExponent = 0;     // 0: report scaling only
+
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        auto number = [&](size_t &into) {
+            auto value = str.substr(str.find('=') + 1);
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || std::stoul(value) == 0) return false;
+            into = std::stoul(value);
+            return true;
+        };
+        if (str == "-O0" || str == "-O1" || str == "-O2") {
+            level = str[2] - '0';
+        } else if (str.rfind("--max-exponent=", 0) == 0 && str.size() > 15
+                   && str.find_first_not_of("0123456789.", 15) == std::string::npos) {
+            maxExponent = std::stod(str.substr(15));
+        } else if (str.rfind("--shape=", 0) == 0 && shapes.count(str.substr(8))) {
+            selected.push_back(str.substr(8));
+        } else if (!((str.rfind("--size=", 0) == 0 && number(size)) || (str.rfind("--steps=", 0) == 0 && number(steps))
+                     || (str.rfind("--runs=", 0) == 0 && number(runs))
+                     || (str.rfind("--parse-threads=", 0) == 0 && number(parseThreads)))) {
+            std::cerr << "usage: " << executable << " [--shape=NAME]... [--size=N] [--steps=K] [--runs=R] [-O0|-O1|-O2] [--max-exponent=E]"
+                      << " [--parse-threads=T]\n"
+                      << "  times every phase on programs of size N, 2N, ... 2^(K-1)N, R runs each, and fails if\n"
+                      << "  one's time grows faster than size^E; with T, also parses the largest on 1, 2, 4, ... T\n"
+                      << "  threads; shapes:";
+            for (auto &[name, generate]: shapes) std::cerr << " " << name;
+            std::cerr << "\n";
+            return 1;
+        }
+    }
+    if (selected.empty()) {
+        for (auto &[name, generate]: shapes) selected.push_back(name);
+    }
+
+    std::cout << std::fixed << "scanner kernel: " << scanKernel() << "\n\n";
+    std::vector<std::string> tooSlow;
+    for (auto &shape: selected) {
+        std::vector<Sample> samples;
+        for (size_t step = 0, n = size; step < steps; step++, n *= 2) {
+            auto code = shapes.at(shape)(n);
+            Sample sample{n};
+            for (size_t run = 0; run < runs; run++) {
+                if (!measure(code, level, sample)) {
+                    std::cerr << executable << ": generated " << shape << " program of size " << n << " does not compile\n";
+                    return 1;
+                }
+            }
+            samples.push_back(sample);
+        }
+
+        std::cout << shape << " (-O" << level << ", mean ± standard deviation of " << runs << " runs, ms)\n";
+        std::cout << std::setw(7) << "size" << std::setw(8) << "tokens" << std::setw(8) << "nodes" << std::setw(8) << "instrs";
+        for (auto &phase: phases) std::cout << std::setw(20) << phase;
+        std::cout << "\n";
+        for (auto &sample: samples) {
+            std::cout << std::setw(7) << sample.size << std::setw(8) << sample.tokens << std::setw(8) << sample.nodes
+                      << std::setw(8) << sample.instructions;
+            for (auto &phase: phases) {
+                auto &seconds = sample.seconds.at(phase);
+                std::cout << std::setw(11) << std::setprecision(3) << mean(seconds) * 1e3
+                          << " ±" << std::setw(7) << deviation(seconds) * 1e3;
+            }
+            std::cout << "\n";
+        }
+
+        // rates at the largest size, and the exponent k of time ~ size^k from the smallest to the largest
+        auto &last = samples.back();
+        auto rate = [&](const std::string &phase, size_t units) { return units / mean(last.seconds.at(phase)); };
+        std::cout << std::setprecision(0) << "  throughput: lex " << rate("lex", last.tokens) << " tokens/s, parse "
+                  << rate("parse", last.nodes) << " nodes/s, semantics " << rate("semantics", last.nodes)
+                  << " nodes/s, lower " << rate("lower", last.instructions) << " instructions/s, optimize "
+                  << rate("optimize", last.instructions) << " instructions/s\n";
+        if (samples.size() > 1) {
+            std::cout << std::setprecision(2) << "  scaling:";
+            auto &first = samples.front();
+            for (auto &phase: phases) {
+                auto exponent = std::log(mean(last.seconds.at(phase)) / mean(first.seconds.at(phase)))
+                              / std::log(static_cast<double>(last.size) / first.size);
+                std::cout << " " << phase << " n^" << exponent << (exponent >= 1.5 ? " (superlinear)" : "");
+                if (maxExponent && exponent > maxExponent) tooSlow.push_back(shape + " " + phase);
+            }
+            std::cout << "\n";
+        }
+        if (parseThreads) {
+            auto code = shapes.at(shape)(last.size);
+            auto serial = timeParse(code, 0, runs);
+            std::cout << std::setprecision(3) << "  parse of size " << last.size << ": serial " << serial * 1e3 << " ms";
+            for (size_t threads = 1; threads <= parseThreads; threads *= 2) {
+                auto parallel = timeParse(code, threads, runs);
+                std::cout << ", " << threads << (threads == 1 ? " thread " : " threads ") << parallel * 1e3 << " ms ("
+                          << std::setprecision(2) << serial / parallel << "x)" << std::setprecision(3);
+            }
+            std::cout << "\n";
+        }
+        std::cout << "\n";
+    }
+    for (auto &phase: tooSlow) {
+        std::cerr << executable << ": " << phase << " grows faster than size^" << std::setprecision(2) << maxExponent << "\n";
+    }
+    return tooSlow.empty() ? 0 : 1;
+}
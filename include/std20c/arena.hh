@@ -0,0 +1,84 @@
+#ifndef ARENA_HH
+#define ARENA_HH
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <new>
+#include <set>
+#include <vector>
+
+// a bump allocator for the data of one compilation: allocations are carved out of large blocks, freeing
+//  them does nothing, and reset() frees all of them at once while keeping the blocks for the next one
+class Arena {
+public:
+    Arena() = default;
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(std::size_t bytes, std::size_t alignment);
+    bool owns(const void *p) const;
+    void reset();
+private:
+    struct Block {
+        char *begin, *end;
+    };
+    std::vector<Block> blocks;
+    std::size_t current = 0;    // the block allocations are carved out of
+    char *next = nullptr;       // its first free byte
+};
+
+// the arena of the calling thread while an ArenaScope is open on it, nullptr otherwise
+inline thread_local Arena *activeArena = nullptr;
+
+// makes ArenaAllocators on the calling thread allocate from the thread's arena until the outermost scope
+//  closes and resets it; everything allocated inside must be destroyed before then
+struct ArenaScope {
+    ArenaScope();
+    ~ArenaScope();
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+private:
+    bool outermost;
+};
+
+// makes ArenaAllocators on the calling thread allocate from the heap, inside an ArenaScope, until it
+//  closes: for data that has to outlive the arena, like a tree a worker thread hands to another. Nothing
+//  allocated from the arena may be freed meanwhile
+struct HeapScope {
+    HeapScope();
+    ~HeapScope();
+    HeapScope(const HeapScope &) = delete;
+    HeapScope &operator=(const HeapScope &) = delete;
+private:
+    Arena *arena;
+};
+
+// allocates from the active arena, or from the heap outside an ArenaScope (so the same types work in
+//  code that never opens one, like std20vm); stateless, so containers move and swap freely
+template<typename T>
+struct ArenaAllocator {
+    using value_type = T;
+    ArenaAllocator() = default;
+    template<typename U> ArenaAllocator(const ArenaAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        if (activeArena) return static_cast<T *>(activeArena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *p, std::size_t) {
+        if (activeArena && activeArena->owns(p)) return;
+        ::operator delete(p);
+    }
+};
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return true; }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return false; }
+
+template<typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+template<typename T> using ArenaDeque = std::deque<T, ArenaAllocator<T>>;
+template<typename T> using ArenaSet = std::set<T, std::less<T>, ArenaAllocator<T>>;
+template<typename K, typename V> using ArenaMap = std::map<K, V, std::less<K>, ArenaAllocator<std::pair<const K, V>>>;
+
+#endif
@@ -2,6 +2,7 @@
 #define COMPILER_HH
 
 #include <map>
+#include <std20c/arena.hh>
 #include <string>
 #include <vector>
 enum Type {
@@ -25,11 +26,11 @@ struct SymbolTable {
             excludes ID tokens referenced in declaration
             needed as strings by themselves are not enough to due to scopes
      */
-    std::map<const Token*, VariableID> tokenToVID;
+    ArenaMap<const Token*, VariableID> tokenToVID;
     //  vidToType => maps VID to respective type
-    std::map<VariableID, Type> vidToType;
+    ArenaMap<VariableID, Type> vidToType;
     //  maps function name to respective function type
-    std::map<std::string, Function> funNameToType; 
+    ArenaMap<std::string, Function> funNameToType;
 };
 
 
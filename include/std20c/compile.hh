@@ -0,0 +1,37 @@
+#ifndef COMPILE_HH
+#define COMPILE_HH
+#include <std20c/error_message.hh>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the compiler as a library (libstd20c): compile() may run on any number of threads at once and writes
+//  nothing to stdout, stderr or the file system
+
+struct CompileOptions {
+    std::size_t optimize = 0;           // as -O0, -O1, -O2
+    std::size_t unrollBudget = 4096;    // as -funroll-budget=N
+};
+
+struct Diagnostic {
+    CompilerError::Type type;
+    std::size_t offset;         // of the offending text in the source, in bytes
+    std::size_t length;
+    std::size_t line, column;   // of `offset`, from 1
+    std::string message;
+};
+
+struct CompileResult {
+    bool success;
+    std::vector<Diagnostic> diagnostics;    // every error found, in order; empty on success
+};
+
+// compiles `source` into `output` (replacing what it held, cleared on failure); reusing one output
+//  string for many compilations reuses its memory too
+CompileResult compile(std::string_view source, const CompileOptions &options, std::string &output);
+
+// the diagnostic as std20c prints it: position, message and the source line with the error underlined
+std::string formatDiagnostic(std::string_view source, const Diagnostic &diagnostic);
+
+#endif
@@ -1,18 +1,40 @@
 #ifndef ERROR_MESSAGE_HH
 #define ERROR_MESSAGE_HH
 #include <string>
+#include <string_view>
 #include <cstddef>
+#include <iosfwd>
+#include <tuple>
+#include <vector>
 
 struct CompilerError {
     enum Type { SCAN, PARSE, TYPE, COMPILE } type;
-    std::string::const_iterator errorPosition;
+    const char *errorPosition;  // into the source
     size_t errorLength;
     std::string errorMessage;
-    CompilerError(enum Type type, std::string::const_iterator errorPosition, size_t errorLength, std::string errorMessage): 
+    CompilerError(enum Type type, const char *errorPosition, size_t errorLength, std::string errorMessage): 
         type(type), errorPosition(errorPosition), errorLength(errorLength), errorMessage(errorMessage) {}
 };
 
-// input => original; position
-int generateErrorMessage(const std::string &contents, CompilerError error);
+// line and column (from 1) of `it` in `contents`
+std::tuple<size_t, size_t> getLnCol(std::string_view contents, const char *it);
+
+// where every line of `contents` starts, found in one pass, so that the line and column of each of many
+//  positions take a binary search instead of a pass of their own
+class LineIndex {
+public:
+    explicit LineIndex(std::string_view contents);
+    // as getLnCol
+    std::tuple<size_t, size_t> lineAndColumn(const char *it) const;
+private:
+    const char *begin;
+    std::vector<size_t> lineStarts;     // offsets, the first 0
+};
+
+// input => original; position; written to `os`, or to stderr
+int generateErrorMessage(std::ostream &os, std::string_view contents, CompilerError error);
+int generateErrorMessage(std::string_view contents, CompilerError error);
+// as above, for an error whose line and column are known
+int generateErrorMessage(std::ostream &os, std::string_view contents, CompilerError error, size_t ln, size_t col);
 
 #endif
\ No newline at end of file
@@ -3,9 +3,13 @@
 #include <string>
 #include <vector>
 #include <variant>
+#include <optional>
 #include <set>
+#include <std20c/arena.hh>
 
 using VReg = std::size_t;
+// vregs below this are std20's predefined slots (SELF, TARGET) and must keep their slot number
+constexpr VReg reservedRegisters = 2;
 
 struct ImmediateAssignInstruction {
     VReg lhs;
@@ -17,16 +21,20 @@ struct RegisterAssignInstruction {
     VReg rhs;
     RegisterAssignInstruction(VReg lhs, VReg rhs): lhs(lhs), rhs(rhs) {}
 };
+// an instruction's opcode and operands; instructions and operand lists live in the compilation's arena
+using OperandList = ArenaVector<std::variant<VReg, std::string>>;
 struct GenericWriteInstruction {
     VReg lhs;
-    std::vector<std::variant<VReg, std::string>> rhs;
+    OperandList rhs;
     GenericWriteInstruction(VReg lhs, std::initializer_list<std::variant<VReg, std::string>> list): lhs(lhs), rhs(list) {}
-    GenericWriteInstruction(VReg lhs, std::vector<std::variant<VReg, std::string>> list): lhs(lhs), rhs(list) {}
+    GenericWriteInstruction(VReg lhs, OperandList list): lhs(lhs), rhs(std::move(list)) {}
+    GenericWriteInstruction(VReg lhs, const std::vector<std::variant<VReg, std::string>> &list): lhs(lhs), rhs(list.begin(), list.end()) {}
 };
 struct GenericReadInstruction {
-    std::vector<std::variant<VReg, std::string>> instruction;
+    OperandList instruction;
     GenericReadInstruction(std::initializer_list<std::variant<VReg, std::string>> list): instruction(list) {}
-    GenericReadInstruction(std::vector<std::variant<VReg, std::string>> list): instruction(list) {}
+    GenericReadInstruction(OperandList list): instruction(std::move(list)) {}
+    GenericReadInstruction(const std::vector<std::variant<VReg, std::string>> &list): instruction(list.begin(), list.end()) {}
 };
 using Instruction = std::variant<ImmediateAssignInstruction, RegisterAssignInstruction, GenericWriteInstruction, GenericReadInstruction>;
 
@@ -82,9 +90,28 @@ void visitVReg(Instruction &ins, ReadFn read, WriteFn write) {
     }, ins);
 }
 
+// registers read by an instruction in operand order; all reads happen before the write
+inline std::vector<VReg> readRegisters(const Instruction &ins) {
+    std::vector<VReg> reads;
+    visitVReg(ins, [&](const VReg &v) { reads.push_back(v); }, [](const VReg &) {});
+    return reads;
+}
+inline std::optional<VReg> writtenRegister(const Instruction &ins) {
+    std::optional<VReg> write;
+    visitVReg(ins, [](const VReg &) {}, [&](const VReg &v) { write = v; });
+    return write;
+}
+
+using Instructions = ArenaVector<Instruction>;
 struct IR {
-    std::set<VReg> virtualRegisters;
-    std::vector<Instruction> instructions;
+    ArenaSet<VReg> virtualRegisters;
+    Instructions instructions;
+    // a register that is not used anywhere in the program yet
+    VReg generateNewReg() {
+        auto retReg = virtualRegisters.empty() ? 0 : *virtualRegisters.rbegin() + 1;
+        virtualRegisters.insert(retReg);
+        return retReg;
+    }
 };
 
 
@@ -5,6 +5,7 @@
 #include <variant>
 #include <vector>
 #include <regex>
+#include <std20c/arena.hh>
 
 enum Terminals {
     SPACE, COMMENT, SEMICOLON, IF, ELSE, LPAREN, RPAREN, LBPAREN, RBPAREN, WHILE, TYPE, ID, ASSIGN, LOR, LAND, EQ, NE, LE, LT, GE, GT, PLUS, MINUS, STAR, SLASH, EXCLAIM, PERIOD, NUMBER, STRING, COMMA
@@ -22,48 +23,18 @@ struct KindToRegex {
     KindToRegex(Terminals kind, std::string regex): kind(kind), regex(regex) {}
 };
 struct Token {
-    std::string::const_iterator begin;
+    const char *begin;  // into the source
     std::size_t length; // length of the lexeme
     Terminals kind;
-    Token(std::string::const_iterator begin, std::size_t length, Terminals kind): begin(begin), length(length), kind(kind) {}
+    Token(const char *begin, std::size_t length, Terminals kind): begin(begin), length(length), kind(kind) {}
     std::string toString() const {
         return std::string(begin, begin + length);
     }
 };
-const std::vector<KindToRegex> tokenizationRules {
-    {SPACE, "^\\s+"},
-    {COMMENT, "^\\/\\/.+"},
-    {SEMICOLON, "^;"},
-    {IF, "^if"},
-    {ELSE, "^else"},
-    {LPAREN, "^\\("},
-    {RPAREN, "^\\)"},
-    {LBPAREN, "^\\{"},
-    {RBPAREN, "^\\}"},
-    {WHILE, "^while"},
-    {TYPE, "(^Entity)|(^Number)|(^Vector)|(^String)"},
-    {NUMBER, "^\\d+(\\.\\d+)?"},
-    {STRING, "^\".*\""},
-    {ID, "^[a-zA-Z_][a-zA-Z0-9_]*"},
-    {ASSIGN, "^="},
-    {LOR, "^\\|\\|"},
-    {LAND, "^\\&\\&"},
-    {EQ, "^=="},
-    {NE, "^!="},
-    {LE, "^<="},
-    {LT, "^<"},
-    {GE, "^>="},
-    {GT, "^>"},
-    {PLUS, "^\\+"},
-    {MINUS, "^-"},
-    {STAR, "^\\*"},
-    {SLASH, "^\\/"},
-    {EXCLAIM, "^!"},
-    {PERIOD, "^\\."},
-    {COMMA, "^\\,"}
-};
+// the regex of every terminal, compiled on first use (see scan/tokenize.cc)
+const std::vector<KindToRegex> &tokenizationRules();
 
-const std::vector<ProductionRule> grammar {
+inline const std::vector<ProductionRule> grammar {
     {START, {BSTMTS}},
     {BSTMTS, {BSTMTS, BSTMT}},
     {BSTMTS, {}},
@@ -120,9 +91,8 @@ using Tree = std::variant<Branch, Token>;
 struct Branch {
     NonTerminals nt;
     std::size_t left, right;
-    std::vector<Tree> subtrees;
-    Branch(NonTerminals nt, std::size_t left, std::size_t right, std::vector<Tree> subtrees): nt(nt), left(left), right(right), subtrees(subtrees) {}
-    ~Branch() = default;
+    ArenaVector<Tree> subtrees;
+    Branch(NonTerminals nt, std::size_t left, std::size_t right, ArenaVector<Tree> subtrees): nt(nt), left(left), right(right), subtrees(std::move(subtrees)) {}
 };
 
 
@@ -13,14 +13,21 @@ Type tokenToType(Token t) {
 
 struct SemanticState {
     SymbolTable &symbolTable;
-    VariableScopeContext context{};
+    VariableScopeContext &context;
 
-    std::optional<CompilerError> error{std::nullopt};
-    SemanticState(SymbolTable &symbolTable): symbolTable(symbolTable) {};
+    std::optional<CompilerError> error{std::nullopt};   // of the statement being checked
+    std::vector<CompilerError> errors;                  // of the statements checked so far, in order
+    SemanticState(SymbolTable &symbolTable, VariableScopeContext &context): symbolTable(symbolTable), context(context) {};
 };
 
 std::optional<Type> genExpr(SemanticState &state, const Tree &t);
 
+// keeps the error of a statement that failed, so the statements after it are checked too
+void recover(SemanticState &state) {
+    if (state.error) state.errors.push_back(std::move(*state.error));
+    state.error.reset();
+}
+
 bool genArgs(SemanticState &state, const Tree &t, std::vector<Type>& types) {
     auto &branch = std::get<Branch>(t);
     assert((!state.error && branch.nt == NonTerminals::ARGS));
@@ -245,6 +252,9 @@ std::optional<Type> genVarDef(SemanticState &state, const Tree &t) {
             } else {
                 if (exprAsType.has_value())
                     state.error = assignMismatchError(idAsToken, *exprAsType, idTypeAsType);
+                // defined all the same, so its uses after this are not errors too
+                auto vid = state.context.defineVariableInScope(idAsStr);
+                state.symbolTable.vidToType.emplace(vid, idTypeAsType);
                 return std::nullopt;
             }
         } else {
@@ -287,30 +297,24 @@ std::optional<Type> genBStmt(SemanticState &state, const Tree &t) {
 
                 auto [_1, _2, expr, _3, bstmt, ifcont] = vectorView<6>(branch.subtrees);
 
+                // the branches are checked even if the condition or the first branch has an error
                 auto res = genExpr(state, expr);
-                if (res == Type::NUMBER_TYPE) {
-
-                    if (auto res2 = genBStmt(state, bstmt)) {
-                        return genIfCont(state, ifcont);
-                    } else {
-                        return std::nullopt;
-                    }
-                } else {
-                    if (res.has_value())
-                        state.error = invalidTypeError(std::get<Token>(_1), Type::NUMBER_TYPE, *res);
-                    return std::nullopt;
-                }
-                
+                if (res.has_value() && res != Type::NUMBER_TYPE)
+                    state.error = invalidTypeError(std::get<Token>(_1), Type::NUMBER_TYPE, *res);
+                recover(state);
+                auto res2 = genBStmt(state, bstmt);
+                recover(state);
+                auto res3 = genIfCont(state, ifcont);
+                return res == Type::NUMBER_TYPE && res2 ? res3 : std::nullopt;
             }
             case WHILE: {
                 auto [_1, _2, expr, _3, bstmt] = vectorView<5>(branch.subtrees);
                 auto res = genExpr(state, expr);
-                if (res == Type::NUMBER_TYPE) {
-                    return genBStmt(state, bstmt);
-                    if (res.has_value())
-                        invalidTypeError(std::get<Token>(_1), Type::NUMBER_TYPE, *res);
-                    return std::nullopt;
-                }
+                if (res.has_value() && res != Type::NUMBER_TYPE)
+                    state.error = invalidTypeError(std::get<Token>(_1), Type::NUMBER_TYPE, *res);
+                recover(state);
+                auto res2 = genBStmt(state, bstmt);
+                return res == Type::NUMBER_TYPE ? res2 : std::nullopt;
             }
             default: assert((false));
         }
@@ -349,7 +353,10 @@ std::optional<Type> genBStmts(SemanticState &state, const Tree &t) {
     }
     else if (branch.subtrees.size() == 2) {
         auto [bstmts, bstmt] = vectorView<2>(branch.subtrees);
-        if (genBStmts(state, bstmts) == Type::VOID_TYPE && genBStmt(state, bstmt) == Type::VOID_TYPE) {
+        auto res = genBStmts(state, bstmts);
+        auto res2 = genBStmt(state, bstmt);
+        recover(state);
+        if (res == Type::VOID_TYPE && res2 == Type::VOID_TYPE) {
             return Type::VOID_TYPE;
         } else {
             return std::nullopt;
@@ -368,13 +375,13 @@ std::optional<Type> genStart(SemanticState &state, const Tree &t) {
     return ret;
 }
 
-void initState(SemanticState &state) {
-    state.context.enterScope();
-    state.symbolTable.vidToType = {
-        {state.context.defineVariableInScope("SELF"), Type::ENTITY_TYPE},   // $0
-        {state.context.defineVariableInScope("TARGET"), Type::ENTITY_TYPE}  // $1
+void initState(SymbolTable &symbolTable, VariableScopeContext &context) {
+    context.enterScope();
+    symbolTable.vidToType = {
+        {context.defineVariableInScope("SELF"), Type::ENTITY_TYPE},   // $0
+        {context.defineVariableInScope("TARGET"), Type::ENTITY_TYPE}  // $1
     };
-    state.symbolTable.funNameToType = {
+    symbolTable.funNameToType = {
         {"round", {{Type::NUMBER_TYPE}, Type::NUMBER_TYPE}},
         {"sqrt", {{Type::NUMBER_TYPE}, Type::NUMBER_TYPE}},
         {"sin", {{Type::NUMBER_TYPE}, Type::NUMBER_TYPE}},
@@ -419,17 +426,30 @@ void initState(SemanticState &state) {
     };
 }
 
-std::variant<CompilerError, SymbolTable> generateSymbolTable(const Tree &t) {
+std::variant<CompilerError, SymbolTable> generateSymbolTable(const Tree &t, std::vector<CompilerError> *errors) {
     SymbolTable symbolTable;
-    
-    SemanticState state(symbolTable);
-    initState(state);
-    assert(!state.error);
+    VariableScopeContext context;
+    initState(symbolTable, context);
+    SemanticState state(symbolTable, context);
     genStart(state, t);
-    if (state.error) {
-        return *state.error;
+    recover(state);
+    if (!state.errors.empty()) {
+        if (errors) *errors = state.errors;
+        return state.errors.front();
     } else {
         return symbolTable;
     }
 }
 
+StatementSemantics::StatementSemantics() {
+    initState(symbolTable, context);
+}
+
+std::optional<CompilerError> checkStatements(StatementSemantics &semantics, const Tree &statements) {
+    SemanticState state(semantics.symbolTable, semantics.context);
+    genBStmts(state, statements);
+    recover(state);
+    if (state.errors.empty()) return std::nullopt;
+    return state.errors.front();
+}
+
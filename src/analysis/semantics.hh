@@ -3,9 +3,23 @@
 #include <std20c/compilation.hh>
 #include <std20c/error_message.hh>
 #include <std20c/language.hh>
+#include "scope.hh"
+#include <optional>
 #include <vector>
 
-std::variant<CompilerError, SymbolTable> generateSymbolTable(const Tree &t);
+// the symbol table of a program, or its first error; checking goes on past an error to the end of the
+//  statement it is in and on with the next, and every error found goes to `errors` if given
+std::variant<CompilerError, SymbolTable> generateSymbolTable(const Tree &t, std::vector<CompilerError> *errors = nullptr);
+
+// semantic analysis of a program a few top-level statements at a time: the variables and types of earlier
+//  statements carry over, and so do the token entries of the symbol table unless they are cleared
+struct StatementSemantics {
+    SymbolTable symbolTable;
+    VariableScopeContext context;   // its idCounter numbers the next variable
+    StatementSemantics();
+};
+// checks top-level statements (a BSTMTS), adding the variables they define
+std::optional<CompilerError> checkStatements(StatementSemantics &, const Tree &statements);
 
 // function call wrong number/types of arguments
 CompilerError invalidArgumentError(const Token &id, const std::vector<Type> &expected, const std::vector<Type> &obtained);
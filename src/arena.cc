@@ -0,0 +1,76 @@
+#include <std20c/arena.hh>
+#include <cstdint>
+
+// blocks double from the first size on; reset() frees the blocks past the retained size, so one huge
+//  compilation does not pin its memory for the rest of a batch or server
+constexpr std::size_t firstBlock = 64 * 1024;
+constexpr std::size_t retainedBytes = 64 * 1024 * 1024;
+
+Arena::~Arena() {
+    for (auto &block: blocks) ::operator delete(block.begin);
+}
+
+void *Arena::allocate(std::size_t bytes, std::size_t alignment) {
+    while (true) {
+        if (current < blocks.size()) {
+            auto address = reinterpret_cast<std::uintptr_t>(next);
+            auto aligned = reinterpret_cast<char *>((address + alignment - 1) & ~(alignment - 1));
+            if (aligned + bytes <= blocks[current].end) {
+                next = aligned + bytes;
+                return aligned;
+            }
+            if (current + 1 < blocks.size()) {
+                next = blocks[++current].begin;
+                continue;
+            }
+        }
+        auto size = blocks.empty() ? firstBlock : static_cast<std::size_t>(blocks.back().end - blocks.back().begin) * 2;
+        while (size < bytes + alignment) size *= 2;
+        auto begin = static_cast<char *>(::operator new(size));
+        blocks.push_back(Block{begin, begin + size});
+        current = blocks.size() - 1;
+        next = begin;
+    }
+}
+
+bool Arena::owns(const void *p) const {
+    auto c = static_cast<const char *>(p);
+    // most frees are of recent allocations, so the current block goes first
+    if (current < blocks.size() && blocks[current].begin <= c && c < blocks[current].end) return true;
+    for (auto &block: blocks) {
+        if (block.begin <= c && c < block.end) return true;
+    }
+    return false;
+}
+
+void Arena::reset() {
+    std::size_t kept = 0, size = 0;
+    for (; kept < blocks.size(); kept++) {
+        size += blocks[kept].end - blocks[kept].begin;
+        if (size > retainedBytes) break;
+    }
+    for (auto i = kept; i < blocks.size(); i++) ::operator delete(blocks[i].begin);
+    blocks.resize(kept);
+    current = 0;
+    next = blocks.empty() ? nullptr : blocks[0].begin;
+}
+
+thread_local Arena threadArena;
+
+ArenaScope::ArenaScope(): outermost(!activeArena) {
+    if (outermost) activeArena = &threadArena;
+}
+
+ArenaScope::~ArenaScope() {
+    if (!outermost) return;
+    threadArena.reset();
+    activeArena = nullptr;
+}
+
+HeapScope::HeapScope(): arena(activeArena) {
+    activeArena = nullptr;
+}
+
+HeapScope::~HeapScope() {
+    activeArena = arena;
+}
@@ -0,0 +1,131 @@
+#include "emit.hh"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+constexpr std::string_view programHeader = "#lang std20\n";
+constexpr std::size_t chunkSize = 1 << 20;  // bytes an IRWriter formats before writing them
+
+std::size_t decimalDigits(VReg v) {
+    std::size_t digits = 1;
+    for (; v >= 10; v /= 10) digits++;
+    return digits;
+}
+
+// every operand is followed by a space
+std::size_t operandsSize(const OperandList &operands) {
+    std::size_t size = 0;
+    for (auto &operand: operands) {
+        if (std::holds_alternative<VReg>(operand)) size += 1 + decimalDigits(std::get<VReg>(operand)) + 1;
+        else size += std::get<std::string>(operand).size() + 1;
+    }
+    return size;
+}
+
+std::size_t lineSize(const Instruction &ins) {
+    return std::visit([](auto &arg) -> std::size_t {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, ImmediateAssignInstruction>) {
+            return 1 + decimalDigits(arg.lhs) + 7 + arg.value.size() + 1;
+        } else if constexpr (std::is_same_v<T, RegisterAssignInstruction>) {
+            return 1 + decimalDigits(arg.lhs) + 8 + decimalDigits(arg.rhs) + 1;
+        } else if constexpr (std::is_same_v<T, GenericWriteInstruction>) {
+            return 1 + decimalDigits(arg.lhs) + 3 + operandsSize(arg.rhs) + 1;
+        } else {
+            return operandsSize(arg.instruction) + 1;
+        }
+    }, ins);
+}
+
+// the formatters write exactly the bytes counted above and return the end of what they wrote
+char *put(char *out, std::string_view text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+char *putRegister(char *out, VReg v) {
+    *out++ = '$';
+    return std::to_chars(out, out + decimalDigits(v), v).ptr;
+}
+char *putOperands(char *out, const OperandList &operands) {
+    for (auto &operand: operands) {
+        if (std::holds_alternative<VReg>(operand)) out = putRegister(out, std::get<VReg>(operand));
+        else out = put(out, std::get<std::string>(operand));
+        *out++ = ' ';
+    }
+    return out;
+}
+
+char *formatLine(const Instruction &ins, char *out) {
+    out = std::visit([&](auto &arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, ImmediateAssignInstruction>) {
+            return put(put(putRegister(out, arg.lhs), " = mov "), arg.value);
+        } else if constexpr (std::is_same_v<T, RegisterAssignInstruction>) {
+            return putRegister(put(putRegister(out, arg.lhs), " = mov "), arg.rhs);
+        } else if constexpr (std::is_same_v<T, GenericWriteInstruction>) {
+            return putOperands(put(putRegister(out, arg.lhs), " = "), arg.rhs);
+        } else {
+            return putOperands(out, arg.instruction);
+        }
+    }, ins);
+    *out++ = '\n';
+    return out;
+}
+
+std::size_t emittedSize(const IR &ir) {
+    auto size = programHeader.size();
+    for (auto &ins: ir.instructions) size += lineSize(ins);
+    return size;
+}
+
+void emitIR(const IR &ir, std::string &into) {
+    auto start = into.size();
+    into.resize(start + emittedSize(ir));
+    auto out = put(into.data() + start, programHeader);
+    for (auto &ins: ir.instructions) out = formatLine(ins, out);
+}
+
+IRWriter::IRWriter(int fd, std::size_t expected): fd(fd) {
+    buffer.reserve(std::min(expected, chunkSize));
+    buffer += programHeader;
+}
+
+bool IRWriter::write(const Instructions &instructions) {
+    for (auto &ins: instructions) {
+        if (failed) return false;
+        auto size = lineSize(ins);
+        // a line longer than a chunk gets a buffer of its own
+        if (!buffer.empty() && buffer.size() + size > chunkSize) {
+            failed = !writeText(fd, buffer);
+            buffer.clear();
+        }
+        auto start = buffer.size();
+        buffer.resize(start + size);
+        formatLine(ins, buffer.data() + start);
+    }
+    return !failed;
+}
+
+bool IRWriter::finish() {
+    buffer += '\n';
+    failed = failed || !writeText(fd, buffer);
+    buffer.clear();
+    return !failed;
+}
+
+bool writeIR(int fd, const IR &ir) {
+    IRWriter writer(fd, emittedSize(ir) + 1);
+    return writer.write(ir.instructions) && writer.finish();
+}
+
+bool writeText(int fd, std::string_view text) {
+    while (!text.empty()) {
+        auto n = write(fd, text.data(), text.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        text.remove_prefix(n);
+    }
+    return true;
+}
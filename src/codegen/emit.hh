@@ -0,0 +1,36 @@
+#ifndef EMIT_HH
+#define EMIT_HH
+#include <std20c/ir.hh>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// the program text of an IR: "#lang std20" and one line per instruction, registers written `$<vreg>`;
+//  an output file is the program followed by one empty line
+
+// bytes in the program text
+std::size_t emittedSize(const IR &);
+// appends the program text to `into`, growing it once
+void emitIR(const IR &, std::string &into);
+
+// writes an output file to `fd` as the instructions of the program arrive, formatted into a buffer that is
+//  written whenever it fills up, so a program that fits takes one write()
+class IRWriter {
+public:
+    // `expected`: about how many bytes the file will take, to size the buffer
+    explicit IRWriter(int fd, std::size_t expected = -1);
+    // false once a write has failed
+    bool write(const Instructions &);
+    // writes what is still buffered, ending the file
+    bool finish();
+private:
+    int fd;
+    std::string buffer;
+    bool failed = false;
+};
+// the output file for `ir`, through an IRWriter; false if a write fails
+bool writeIR(int fd, const IR &ir);
+// writes all of `text` to `fd`; false if a write fails
+bool writeText(int fd, std::string_view text);
+
+#endif
@@ -1,20 +1,19 @@
 #include "lower.hh"
 #include "../vector_util.hh"
 
-std::string generateUniqueLabel() {
-    static int n = 0;
-    return "__L" + std::to_string(n++);
-}
-
 struct LoweringState {
     const SymbolTable &sym;
     IR &ir;
+    LoweringCounters &counters;
+    std::string generateUniqueLabel() {
+        return "__L" + std::to_string(counters.labels++);
+    }
     VReg generateNewReg() {
-        auto retReg = this->ir.virtualRegisters.size();
+        auto retReg = counters.nextRegister++;
         this->ir.virtualRegisters.insert(retReg);
         return retReg;
     }
-    LoweringState(const SymbolTable &sym, IR &ir): sym(sym), ir(ir) {}
+    LoweringState(const SymbolTable &sym, IR &ir, LoweringCounters &counters): sym(sym), ir(ir), counters(counters) {}
 };
 VReg genExpr(LoweringState &state, const Tree &t);
 
@@ -110,8 +109,8 @@ VReg genPre2(LoweringState &state, const Tree &t) {
             case EXCLAIM: {
                 auto pre2Reg = genPre2(state, branch.subtrees.at(1));
                 auto retReg = state.generateNewReg();
-                auto ifTrue = generateUniqueLabel();
-                auto end = generateUniqueLabel();
+                auto ifTrue = state.generateUniqueLabel();
+                auto end = state.generateUniqueLabel();
                 state.ir.instructions.push_back(GenericReadInstruction({"jmpe", ifTrue, pre2Reg, "0"}));
                 state.ir.instructions.push_back(ImmediateAssignInstruction(retReg, "0"));
                 state.ir.instructions.push_back(GenericReadInstruction({"jmpe", end, "0", "0"}));
@@ -151,8 +150,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
     if (std::get<Token>(op).kind == LOR || std::get<Token>(op).kind == LAND) {
         // short circuit expression
         if (std::get<Token>(op).kind == LOR) {
-            auto returnTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto returnTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
 
             auto leftReg = genBinOp(state, left);
             state.ir.instructions.push_back(GenericReadInstruction{"jmpne", returnTrue, leftReg, "0"});
@@ -164,8 +163,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "1"});
             state.ir.instructions.push_back(GenericReadInstruction{"label", end});
         } else {
-            auto returnFalse = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto returnFalse = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
 
             auto leftReg = genBinOp(state, left);
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", returnFalse, leftReg, "0"});
@@ -197,8 +196,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             state.ir.instructions.push_back(GenericWriteInstruction{retReg, {"div", leftReg, rightReg}});
             break;
         case EQ: {
-            auto ifTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto ifTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", ifTrue, leftReg, rightReg});
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "0"});
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", end, "0", "0"});
@@ -208,8 +207,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             break;
         }
         case NE: {
-            auto ifTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto ifTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
             state.ir.instructions.push_back(GenericReadInstruction{"jmpne", ifTrue, leftReg, rightReg});
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "0"});
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", end, "0", "0"});
@@ -218,8 +217,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             state.ir.instructions.push_back(GenericReadInstruction{"label", end});
             break;
         } case GT: {
-            auto ifTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto ifTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
             state.ir.instructions.push_back(GenericReadInstruction{"jmpg", ifTrue, leftReg, rightReg});
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "0"});
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", end, "0", "0"});
@@ -228,8 +227,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             state.ir.instructions.push_back(GenericReadInstruction{"label", end});
             break;
         } case GE: {
-            auto ifTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto ifTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
             state.ir.instructions.push_back(GenericReadInstruction{"jmpge", ifTrue, leftReg, rightReg});
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "0"});
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", end, "0", "0"});
@@ -238,8 +237,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             state.ir.instructions.push_back(GenericReadInstruction{"label", end});
             break;
         } case LE: {
-            auto ifTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto ifTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
             state.ir.instructions.push_back(GenericReadInstruction{"jmple", ifTrue, leftReg, rightReg});
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "0"});
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", end, "0", "0"});
@@ -248,8 +247,8 @@ VReg genBinOp(LoweringState &state, const Tree &t) {
             state.ir.instructions.push_back(GenericReadInstruction{"label", end});
             break;
         } case LT: {
-            auto ifTrue = generateUniqueLabel();
-            auto end = generateUniqueLabel();
+            auto ifTrue = state.generateUniqueLabel();
+            auto end = state.generateUniqueLabel();
             state.ir.instructions.push_back(GenericReadInstruction{"jmpl", ifTrue, leftReg, rightReg});
             state.ir.instructions.push_back(ImmediateAssignInstruction{retReg, "0"});
             state.ir.instructions.push_back(GenericReadInstruction{"jmpe", end, "0", "0"});
@@ -321,8 +320,8 @@ void genBStmt(LoweringState &state, const Tree &t) {
         switch (std::get<Token>(branch.subtrees.at(0)).kind) {
             case IF: {
                 auto [_1, _2, expr, _3, bstmt, ifcont] = vectorView<6>(branch.subtrees);
-                auto iffalse = generateUniqueLabel();
-                auto ifend = generateUniqueLabel();
+                auto iffalse = state.generateUniqueLabel();
+                auto ifend = state.generateUniqueLabel();
                 auto reg = genExpr(state, expr);
                 state.ir.instructions.push_back(GenericReadInstruction({"jmpe", iffalse, reg, "0"}));
                 genBStmt(state, bstmt);
@@ -334,8 +333,8 @@ void genBStmt(LoweringState &state, const Tree &t) {
             }
             case WHILE: {
                 auto [_1, _2, expr, _3, bstmt] = vectorView<5>(branch.subtrees);
-                auto beginning = generateUniqueLabel();
-                auto iffalse = generateUniqueLabel();
+                auto beginning = state.generateUniqueLabel();
+                auto iffalse = state.generateUniqueLabel();
                 state.ir.instructions.push_back(GenericReadInstruction({"label", beginning}));
                 auto reg = genExpr(state, expr);
                 state.ir.instructions.push_back(GenericReadInstruction({"jmpe", iffalse, reg, "0"}));
@@ -381,11 +380,17 @@ void genStart(LoweringState &state, const Tree &t) {
 
 IR generateIR(const SymbolTable &sym, const Tree &t) {
     IR ir;
-    LoweringState state(sym, ir);
-    // add varids to virtual regs
-    for (auto &[a, b]: state.sym.vidToType) {
+    // add varids to virtual regs, temporaries come after them
+    for (auto &[a, b]: sym.vidToType) {
         ir.virtualRegisters.insert(a);
     }
+    LoweringCounters counters{0, ir.virtualRegisters.size()};
+    LoweringState state(sym, ir, counters);
     genStart(state, t);
     return ir;
 }
+
+void generateStatementsIR(const SymbolTable &sym, const Tree &statements, LoweringCounters &counters, IR &ir) {
+    LoweringState state(sym, ir, counters);
+    genBStmts(state, statements);
+}
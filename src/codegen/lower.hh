@@ -6,4 +6,12 @@
 
 IR generateIR(const SymbolTable &, const Tree &);
 
+// what carries over between top-level statements lowered a few at a time
+struct LoweringCounters {
+    size_t labels = 0;          // labels generated so far, numbering the next one
+    VReg nextRegister = 0;      // the next temporary; lower ones hold variables or earlier temporaries
+};
+// appends the instructions of top-level statements (a BSTMTS) to `ir`
+void generateStatementsIR(const SymbolTable &, const Tree &statements, LoweringCounters &, IR &ir);
+
 #endif
\ No newline at end of file
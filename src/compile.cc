@@ -0,0 +1,30 @@
+#include <std20c/compile.hh>
+#include "pipeline.hh"
+#include "codegen/emit.hh"
+#include "instrument/phase.hh"
+#include <sstream>
+
+CompileResult compile(std::string_view source, const CompileOptions &options, std::string &output) {
+    output.clear();
+    ArenaScope arena;
+    UnrollCostModel unroll;
+    unroll.sizeBudget = options.unrollBudget;
+    std::vector<CompilerError> errors;
+    auto tryCompile = compileIR(source, options.optimize, unroll, nullptr, 0, &errors);
+    if (std::holds_alternative<CompilerError>(tryCompile)) {
+        return CompileResult{false, diagnosticsOf(source, errors)};
+    }
+    PhaseScope phase("emit");
+    auto &ir = std::get<IR>(tryCompile);
+    output.reserve(emittedSize(ir) + 1);
+    emitIR(ir, output);
+    output += '\n';
+    return CompileResult{true, {}};
+}
+
+std::string formatDiagnostic(std::string_view source, const Diagnostic &diagnostic) {
+    std::ostringstream os;
+    generateErrorMessage(os, source, CompilerError(diagnostic.type, source.data() + diagnostic.offset, diagnostic.length,
+                                                   diagnostic.message), diagnostic.line, diagnostic.column);
+    return os.str();
+}
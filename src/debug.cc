@@ -1,6 +1,6 @@
 #include "debug.hh"
 #include "std20c/compilation.hh"
-#include <cassert>
+#include "codegen/emit.hh"
 #include <ostream>
 
 std::ostream& operator<<(std::ostream& os, Terminals t) {
@@ -80,12 +80,7 @@ void printTree(std::ostream& o, const Tree &t, std::size_t depth = 0) {
         auto token = std::get<Token>(t);
 
         o << indent << token.kind << " ";
-        auto it = token.begin;
-        for (size_t i = 0; i < token.length; i++) {
-            o << *it;
-            it++;
-        }
-        o << "\n";
+        o << std::string_view(token.begin, token.length) << "\n";
     } else if (std::holds_alternative<Branch>(t)) {
         const auto &branch = std::get<Branch>(t);
         o << indent << "(" << branch.nt << "\n";
@@ -101,44 +96,9 @@ std::ostream& operator<<(std::ostream& os, const Tree &t) {
 }
 
 std::ostream& operator<<(std::ostream &os, const IR &ir) {
-    os << "#lang std20\n";
-    for (auto &e: ir.instructions) {
-        if (std::holds_alternative<GenericWriteInstruction>(e)) {
-            auto &assign = std::get<GenericWriteInstruction>(e);
-            os << "$" << assign.lhs << " = ";
-            for (auto &rhs_e: assign.rhs) {
-                if (std::holds_alternative<VReg>(rhs_e)) {
-                    auto &vreg = std::get<VReg>(rhs_e);
-                    os << "$" << vreg << " ";
-                } else {
-                    auto &str = std::get<std::string>(rhs_e);
-                    os << str << " ";
-                }
-            }
-           os << "\n";
-        } else if (std::holds_alternative<GenericReadInstruction>(e)) {
-            auto &op = std::get<GenericReadInstruction>(e);
-            for (auto &rhs_e: op.instruction) {
-                if (std::holds_alternative<VReg>(rhs_e)) {
-                    auto &vreg = std::get<VReg>(rhs_e);
-                    os << "$" << vreg << " ";
-                } else {
-                    auto &str = std::get<std::string>(rhs_e);
-                    os << str << " ";
-                }
-            }
-            os << "\n";
-        } else if (std::holds_alternative<ImmediateAssignInstruction>(e)) {
-            auto &ins = std::get<ImmediateAssignInstruction>(e);
-            os << "$" << ins.lhs << " = mov " << ins.value << "\n";
-        } else if (std::holds_alternative<RegisterAssignInstruction>(e)) {
-            auto &ins = std::get<RegisterAssignInstruction>(e);
-            os << "$" << ins.lhs << " = mov $" << ins.rhs << "\n";
-        } else {
-            assert((false));
-        }
-    }
-    return os;
+    std::string text;
+    emitIR(ir, text);
+    return os << text;
 }
 
 std::ostream& operator<<(std::ostream &os, const SymbolTable &semantics) {
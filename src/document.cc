@@ -0,0 +1,177 @@
+#include "document.hh"
+#include "scan/tokenize.hh"
+#include "parse/parser.hh"
+#include "parse/chart.hh"
+#include "analysis/semantics.hh"
+#include "codegen/lower.hh"
+#include "instrument/phase.hh"
+#include <algorithm>
+#include <iterator>
+
+struct Document::Statement {
+    std::size_t offset;                     // of its text in the document
+    std::string text;                       // from its first token to the first token of the next statement
+    std::vector<Token> tokens;              // into `text`, without whitespace and comments
+    std::optional<CompilerError> scanError; // into `text`
+    std::optional<std::variant<CompilerError, Tree>> parsed;    // unless it has a scan error
+};
+
+// the top-level statements (a BSTMTS) of a parsed statement
+const Tree &statementsOf(const std::variant<CompilerError, Tree> &parsed) {
+    return std::get<Branch>(std::get<Tree>(parsed)).subtrees.at(0);
+}
+
+Document::Document(std::string_view text): chart(std::make_unique<Chart>(0)) {
+    edit(0, 0, text);
+}
+
+Document::~Document() = default;
+
+void Document::edit(std::size_t offset, std::size_t length, std::string_view text) {
+    source.replace(offset, length, text);
+    auto oldEnd = offset + length;          // where the replaced text ended
+    auto newEnd = offset + text.size();     // and where the new text ends
+    const char *base = source.data(), *end = source.data() + source.size();
+
+    // the first statement the edit touches, counting one that ends where it starts as it may not be complete,
+    //  or the one before that if its last `;` or `}` is now followed by an `else`, which continues it
+    auto touched = std::partition_point(parts.begin(), parts.end(), [&](auto &part) {
+        return part->offset + part->text.size() < offset;
+    });
+    std::size_t first = touched - parts.begin();
+    if (first > 0) {
+        auto begin = base + parts[first - 1]->offset + parts[first - 1]->text.size();
+        std::optional<CompilerError> ignored;
+        auto next = peekSignificant(begin, end, ignored);
+        if (next && next->kind == ELSE) first--;
+    }
+
+    // scans statements from there until one ends where an old statement after the edit starts; the text
+    //  after that is unchanged and scans the same, so the old statements from there on stay
+    std::vector<std::unique_ptr<Statement>> replacement;
+    std::size_t last = first;   // old statements from `first` up to `last` are replaced
+    bool synchronized = false;
+    {
+        PhaseScope phase("scan");
+        auto begin = base + (first < parts.size() ? parts[first]->offset : offset);
+        while (begin != end && !synchronized) {
+            replacement.push_back(scanPart(begin, end));
+            std::size_t next = begin - base;
+            if (next < newEnd) continue;
+            while (last < parts.size() && (parts[last]->offset < oldEnd || parts[last]->offset - oldEnd + newEnd < next)) {
+                last++;
+            }
+            synchronized = last < parts.size() && parts[last]->offset - oldEnd + newEnd == next;
+        }
+    }
+    if (!synchronized) last = parts.size();
+
+    {
+        PhaseScope phase("parse");
+        std::size_t same = first;
+        for (auto &statement: replacement) {
+            // the old statement at the same place, if that is before the edit
+            while (same < last && parts[same]->offset < statement->offset) same++;
+            bool before = same < last && parts[same]->offset == statement->offset && statement->offset <= offset;
+            parse(*statement, before ? parts[same].get() : nullptr);
+        }
+    }
+
+    for (auto i = first; i < last; i++) {
+        if (parts[i].get() == chartOwner) chartOwner = nullptr;
+    }
+    for (auto i = last; i < parts.size(); i++) parts[i]->offset = parts[i]->offset - oldEnd + newEnd;
+    parts.erase(parts.begin() + first, parts.begin() + last);
+    parts.insert(parts.begin() + first, std::make_move_iterator(replacement.begin()), std::make_move_iterator(replacement.end()));
+    lastReparsed = replacement.size();
+}
+
+void Document::update(std::string_view text) {
+    std::size_t prefix = 0, suffix = 0;
+    while (prefix < source.size() && prefix < text.size() && source[prefix] == text[prefix]) prefix++;
+    while (suffix < source.size() - prefix && suffix < text.size() - prefix
+           && source[source.size() - 1 - suffix] == text[text.size() - 1 - suffix]) {
+        suffix++;
+    }
+    edit(prefix, source.size() - prefix - suffix, text.substr(prefix, text.size() - prefix - suffix));
+}
+
+std::unique_ptr<Document::Statement> Document::scanPart(const char *&begin, const char *end) const {
+    auto statement = std::make_unique<Statement>();
+    auto start = begin;
+    scanStatement(begin, end, statement->tokens, statement->scanError);
+    statement->offset = start - source.data();
+    statement->text.assign(start, begin);
+    // the tokens and the error move into the statement's own copy of its text
+    auto moved = [&](const char *position) { return statement->text.data() + (position - start); };
+    for (auto &token: statement->tokens) token.begin = moved(token.begin);
+    if (statement->scanError) statement->scanError->errorPosition = moved(statement->scanError->errorPosition);
+    return statement;
+}
+
+void Document::parse(Statement &statement, const Statement *previous) {
+    // compileIR stops at the scan error, so the statement needs no tree
+    if (statement.scanError) return;
+    // the chart's columns up to the first token of another kind are the same for the new tokens
+    std::size_t reusable = 0;
+    if (previous && previous == chartOwner) {
+        while (reusable < previous->tokens.size() && reusable < statement.tokens.size()
+               && previous->tokens[reusable].kind == statement.tokens[reusable].kind) {
+            reusable++;
+        }
+    }
+    statement.parsed = resumeEarleyParser(statement.tokens, *chart, reusable);
+    chartOwner = &statement;
+}
+
+CompilerError Document::inSource(const Statement &statement, CompilerError error) const {
+    error.errorPosition = source.data() + statement.offset + (error.errorPosition - statement.text.data());
+    return error;
+}
+
+// compileIR reports a scan error anywhere before any parse error
+std::optional<CompilerError> Document::syntaxError() const {
+    for (auto &part: parts) {
+        if (part->scanError) return inSource(*part, *part->scanError);
+    }
+    for (auto &part: parts) {
+        if (std::holds_alternative<CompilerError>(*part->parsed)) return inSource(*part, std::get<CompilerError>(*part->parsed));
+    }
+    return std::nullopt;
+}
+
+std::optional<CompilerError> Document::check() const {
+    if (auto error = syntaxError()) return error;
+    PhaseScope phase("semantics");
+    StatementSemantics semantics;
+    for (auto &part: parts) {
+        semantics.symbolTable.tokenToVID.clear();
+        if (auto error = checkStatements(semantics, statementsOf(*part->parsed))) return inSource(*part, *error);
+    }
+    return std::nullopt;
+}
+
+std::variant<IR, CompilerError> Document::compile(size_t optimize, const UnrollCostModel &unroll,
+                                                  OptimizationStats *stats) const {
+    if (auto error = syntaxError()) return *error;
+    StatementSemantics semantics;
+    {
+        PhaseScope phase("semantics");
+        for (auto &part: parts) {
+            if (auto error = checkStatements(semantics, statementsOf(*part->parsed))) return inSource(*part, *error);
+        }
+    }
+    IR ir;
+    {
+        PhaseScope phase("lower");
+        // as in generateIR, temporaries come after the registers of all variables
+        LoweringCounters counters{0, semantics.context.idCounter};
+        for (VReg v = 0; v < counters.nextRegister; v++) ir.virtualRegisters.insert(v);
+        for (auto &part: parts) generateStatementsIR(semantics.symbolTable, statementsOf(*part->parsed), counters, ir);
+    }
+    if (optimize) {
+        PhaseScope phase("optimize");
+        return optimizer(ir, optimize, unroll, stats);
+    }
+    return ir;
+}
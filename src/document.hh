@@ -0,0 +1,59 @@
+#ifndef DOCUMENT_HH
+#define DOCUMENT_HH
+#include <std20c/error_message.hh>
+#include <std20c/ir.hh>
+#include <std20c/language.hh>
+#include "optimization/optimizer.hh"
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+class Chart;
+
+// a source kept scanned and parsed between edits, for editors and --watch. The text is split into top-level
+//  statements the way streamIR splits it, each owning a copy of its text with its tokens and parse tree, so
+//  an edit scans and parses again only from the statement it touches until a statement ends where an old
+//  one after the edit started. The Earley chart of the statement parsed last is kept, and parsing that
+//  statement again resumes at its first token whose kind changed.
+// The statements live on the heap, so edits must not happen inside an ArenaScope
+class Document {
+public:
+    explicit Document(std::string_view text = {});
+    ~Document();
+    Document(const Document &) = delete;
+    Document &operator=(const Document &) = delete;
+
+    // replaces `length` bytes at `offset` with `text`
+    void edit(std::size_t offset, std::size_t length, std::string_view text);
+    // replaces the whole text, as one edit of what lies between the part the old and new text start with
+    //  and the part they end with
+    void update(std::string_view text);
+    const std::string &text() const { return source; }
+
+    // the error compileIR(text(), ...) reports, if any
+    std::optional<CompilerError> check() const;
+    // the program as compileIR(text(), ...) compiles it, in the caller's ArenaScope if any
+    std::variant<IR, CompilerError> compile(size_t optimize, const UnrollCostModel &unroll,
+                                            OptimizationStats *stats = nullptr) const;
+
+    // top-level statements in the text, and how many of them the last edit scanned and parsed
+    std::size_t statements() const { return parts.size(); }
+    std::size_t reparsed() const { return lastReparsed; }
+private:
+    struct Statement;
+    std::string source;
+    std::vector<std::unique_ptr<Statement>> parts;     // in order, covering the whole text
+    std::unique_ptr<Chart> chart;
+    const Statement *chartOwner = nullptr;              // the statement `chart` was computed for
+    std::size_t lastReparsed = 0;
+
+    std::unique_ptr<Statement> scanPart(const char *&begin, const char *end) const;
+    void parse(Statement &, const Statement *previous);
+    CompilerError inSource(const Statement &, CompilerError) const;
+    std::optional<CompilerError> syntaxError() const;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "cache.hh"
+#include "output_file.hh"
+#include "sha256.hh"
+#include "../codegen/emit.hh"
+#include <std20c/error_message.hh>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+// bumped when the entry format changes
+constexpr const char *entryHeader = "std20c cache 1";
+
+// changes whenever std20c is rebuilt, so no build reuses the output of another
+std::string compilerBuild() {
+    struct stat executable;
+    if (stat("/proc/self/exe", &executable) < 0) return __DATE__ " " __TIME__;
+    return std::to_string(executable.st_size) + " " + std::to_string(executable.st_mtim.tv_sec) + "."
+         + std::to_string(executable.st_mtim.tv_nsec);
+}
+
+std::string cacheKey(std::string_view source, const CompileOptions &options) {
+    static const std::string build = compilerBuild();
+    std::ostringstream flags;
+    flags << entryHeader << '\0' << build << '\0' << "-O" << options.optimize << " -funroll-budget=" << options.unrollBudget << '\0';
+    Sha256 key;
+    key.update(flags.str());
+    key.update(source);
+    return key.finish();
+}
+
+// entries spread over 256 subdirectories named after the key's first two digits
+std::filesystem::path entryPath(const std::string &dir, const std::string &key) {
+    return std::filesystem::path(dir) / key.substr(0, 2) / key.substr(2);
+}
+
+// a number on a line of its own, then `size` bytes of text, which must lie within the `entrySize` bytes
+//  of the entry so a damaged size cannot make it allocate more
+bool getText(std::istream &in, std::string &text, std::uintmax_t entrySize) {
+    std::size_t size;
+    if (!(in >> size) || in.get() != '\n') return false;
+    auto at = in.tellg();
+    if (at < 0 || size > entrySize - static_cast<std::uintmax_t>(at)) return false;
+    text.resize(size);
+    return static_cast<bool>(in.read(text.data(), size));
+}
+void putText(std::ostream &out, const std::string &text) {
+    out << text.size() << "\n" << text;
+}
+
+// whether a diagnostic read back from an entry marks text of `source` and gives the position it starts at
+bool fitsSource(const Diagnostic &diagnostic, std::string_view source, const LineIndex &lines) {
+    if (diagnostic.offset > source.size() || diagnostic.length > source.size() - diagnostic.offset) return false;
+    auto [line, column] = lines.lineAndColumn(source.data() + diagnostic.offset);
+    return line == diagnostic.line && column == diagnostic.column;
+}
+
+// the entry, if every field checks out
+std::optional<CompileResult> readEntry(const std::filesystem::path &path, std::string_view source, std::string &output) {
+    std::error_code error;
+    auto entrySize = std::filesystem::file_size(path, error);
+    std::ifstream in(path, std::ios::binary);
+    std::string header;
+    if (error || !in || !std::getline(in, header) || header != entryHeader) return std::nullopt;
+    CompileResult result;
+    std::size_t diagnostics;
+    if (!(in >> result.success >> diagnostics) || diagnostics > entrySize) return std::nullopt;
+    std::optional<LineIndex> lines;
+    if (diagnostics) lines.emplace(source);
+    for (std::size_t i = 0; i < diagnostics; i++) {
+        int type;
+        Diagnostic diagnostic;
+        if (!(in >> type >> diagnostic.offset >> diagnostic.length >> diagnostic.line >> diagnostic.column)
+            || type < CompilerError::SCAN || type > CompilerError::COMPILE || !getText(in, diagnostic.message, entrySize)) {
+            return std::nullopt;
+        }
+        diagnostic.type = static_cast<CompilerError::Type>(type);
+        if (!fitsSource(diagnostic, source, *lines)) return std::nullopt;
+        result.diagnostics.push_back(diagnostic);
+    }
+    if (!getText(in, output, entrySize) || in.peek() != std::char_traits<char>::eof()) return std::nullopt;
+    return result;
+}
+
+std::optional<CompileResult> lookupCache(const std::string &dir, const std::string &key, std::string_view source,
+                                         std::string &output) {
+    auto result = readEntry(entryPath(dir, key), source, output);
+    if (!result) output.clear();
+    return result;
+}
+
+bool storeCache(const std::string &dir, const std::string &key, const CompileResult &result, const std::string &output) {
+    std::ostringstream entry;
+    entry << entryHeader << "\n" << result.success << " " << result.diagnostics.size() << "\n";
+    for (auto &diagnostic: result.diagnostics) {
+        entry << diagnostic.type << " " << diagnostic.offset << " " << diagnostic.length << " " << diagnostic.line << " "
+              << diagnostic.column << " ";
+        putText(entry, diagnostic.message);
+        entry << "\n";
+    }
+    putText(entry, output);
+
+    auto path = entryPath(dir, key);
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    OutputFile out;
+    return out.open(path.string()) && writeText(out.descriptor(), entry.str()) && out.commit();
+}
@@ -0,0 +1,23 @@
+#ifndef CACHE_HH
+#define CACHE_HH
+#include <std20c/compile.hh>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// an on-disk cache of compilations for --cache-dir: entries are keyed by the SHA-256 of the source, the
+//  options and the build of the compiler, and hold what compile() returned (output and diagnostics)
+
+// the key of compiling `source` with `options` by this build of std20c
+std::string cacheKey(std::string_view source, const CompileOptions &options);
+
+// the compilation of `source` stored under `key`, its output in `output`; nullopt if there is none, or
+//  if it is damaged: any size beyond the entry's end or diagnostic that does not fit `source` is a miss
+std::optional<CompileResult> lookupCache(const std::string &dir, const std::string &key, std::string_view source,
+                                         std::string &output);
+
+// stores a compilation under `key`; entries are written through an OutputFile, so processes and threads
+//  sharing the directory only ever see whole entries; false if it cannot be written
+bool storeCache(const std::string &dir, const std::string &key, const CompileResult &result, const std::string &output);
+
+#endif
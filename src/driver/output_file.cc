@@ -0,0 +1,60 @@
+#include "output_file.hh"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+OutputFile::~OutputFile() {
+    if (fd < 0) return;
+    close(fd);
+    if (!temporary.empty()) unlink(temporary.c_str());
+}
+
+bool OutputFile::openInPlace() {
+    temporary.clear();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    return fd >= 0;
+}
+
+bool OutputFile::open(const std::string &path) {
+    // a symlink stays in place and the file it points to is the one replaced
+    std::error_code error;
+    auto resolved = std::filesystem::canonical(path, error);
+    this->path = error ? path : resolved.string();
+    struct stat existing;
+    if (lstat(this->path.c_str(), &existing) == 0) {
+        // a temporary renamed over the file would lose what makes it more than its contents: a device
+        //  or pipe, a dangling symlink, other hard links, an owner this process cannot give a new file
+        if (!S_ISREG(existing.st_mode) || existing.st_nlink > 1 || existing.st_uid != geteuid() ||
+            existing.st_gid != getegid())
+            return openInPlace();
+    } else {
+        existing.st_mode = 0;
+    }
+    // created as the file itself would be, so the umask applies; a file being replaced keeps its mode
+    std::filesystem::path target(this->path);
+    static std::atomic<unsigned> serial{0};
+    auto prefix = (target.parent_path() / ("." + target.filename().string() + "." + std::to_string(getpid()) + ".")).string();
+    do {
+        temporary = prefix + std::to_string(serial++);
+        fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    } while (fd < 0 && errno == EEXIST);
+    // a directory that takes no new files may still hold a writable one
+    if (fd < 0) return openInPlace();
+    if (existing.st_mode) fchmod(fd, existing.st_mode & 07777);
+    return true;
+}
+
+bool OutputFile::commit() {
+    bool closed = close(fd) == 0;
+    fd = -1;
+    if (temporary.empty()) return closed;
+    if (!closed || std::rename(temporary.c_str(), path.c_str()) < 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef OUTPUT_FILE_HH
+#define OUTPUT_FILE_HH
+#include <string>
+
+// an output file written under a temporary name next to its path and renamed over it once complete, so a
+//  compile that fails half way never leaves part of a file behind; a symlink is followed to the file it names,
+//  and a file a rename would change beyond its contents (/dev/null, a pipe, a hard link, another user's file)
+//  or one whose directory takes no new files is written in place
+class OutputFile {
+public:
+    OutputFile() = default;
+    ~OutputFile();  // removes the temporary file unless it was committed
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    // false if the file cannot be created
+    bool open(const std::string &path);
+    int descriptor() const { return fd; }
+    // closes the file and moves it to its path; false if that fails
+    bool commit();
+private:
+    bool openInPlace();
+
+    std::string path, temporary;   // no temporary when writing in place
+    int fd = -1;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "pool.hh"
+#include "../instrument/trace.hh"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<PoolTask> tasks;
+};
+
+// the tasks of one runWorkStealing call and the workers helping with them
+struct Batch {
+    std::vector<TaskQueue> queues;
+    std::size_t helpersWanted;      // guarded by the pool's mutex, like nextSlot
+    std::size_t nextSlot = 1;       // slot 0 is the caller's
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t unfinished;         // guarded by `mutex`
+
+    explicit Batch(std::size_t threads): queues(threads), helpersWanted(threads - 1) {}
+};
+
+// workers that outlive the batches they help with, so a batch creates no threads once the pool has grown
+//  to the most helpers the batches running at once have asked for
+struct WorkerPool {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<Batch>> open;    // batches that still want helpers
+    std::size_t idle = 0, workers = 0;
+};
+
+// never freed: idle workers wait on it until the process exits
+WorkerPool &workerPool() {
+    static auto &pool = *new WorkerPool;
+    return pool;
+}
+
+// the next task for a worker: the front of its own queue, else the back of another's
+std::optional<PoolTask> takeTask(std::vector<TaskQueue> &queues, std::size_t worker) {
+    for (std::size_t i = 0; i < queues.size(); i++) {
+        auto &queue = queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        PoolTask task;
+        if (i == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        return task;
+    }
+    // tasks never add tasks, so once every queue is empty there is no more work
+    return std::nullopt;
+}
+
+void work(Batch &batch, std::size_t slot) {
+    while (auto task = takeTask(batch.queues, slot)) {
+        (*task)(slot);
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        if (--batch.unfinished == 0) batch.finished.notify_all();
+    }
+}
+
+void poolWorker(WorkerPool &pool, std::size_t index) {
+    nameTraceThread("worker " + std::to_string(index));
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    while (true) {
+        pool.wake.wait(lock, [&] { return !pool.open.empty(); });
+        auto batch = pool.open.front();
+        auto slot = batch->nextSlot++;
+        if (--batch->helpersWanted == 0) pool.open.pop_front();
+        pool.idle--;
+        lock.unlock();
+        {
+            TraceScope scope("worker", "worker");
+            work(*batch, slot);
+        }
+        batch.reset();
+        lock.lock();
+        pool.idle++;
+    }
+}
+
+void runWorkStealing(std::vector<PoolTask> tasks, std::size_t threads) {
+    threads = std::max<std::size_t>(1, std::min(threads, tasks.size()));
+    auto batch = std::make_shared<Batch>(threads);
+    batch->unfinished = tasks.size();
+    for (std::size_t i = 0; i < tasks.size(); i++) batch->queues[i % threads].tasks.push_back(std::move(tasks[i]));
+
+    auto &pool = workerPool();
+    if (threads > 1) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.open.push_back(batch);
+        std::size_t wanted = 0;
+        for (auto &open: pool.open) wanted += open->helpersWanted;
+        for (; pool.idle < wanted; pool.idle++) std::thread(poolWorker, std::ref(pool), pool.workers++).detach();
+        pool.wake.notify_all();
+    }
+    work(*batch, 0);
+    // every task has started; helpers that have not come yet are not needed any more
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto open = std::find(pool.open.begin(), pool.open.end(), batch);
+        if (open != pool.open.end()) pool.open.erase(open);
+    }
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&] { return batch->unfinished == 0; });
+}
@@ -0,0 +1,16 @@
+#ifndef POOL_HH
+#define POOL_HH
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// a task, given the index of the worker running it
+using PoolTask = std::function<void(std::size_t worker)>;
+
+// runs every task on `threads` workers and returns once all are done; tasks are dealt out round-robin,
+//  each worker runs its own in order and then steals from the back of the others' queues. The calling
+//  thread is worker 0, so nested calls finish even when every other worker is busy; the rest come from a
+//  pool kept for the life of the process, so a call creates no threads once the pool is large enough
+void runWorkStealing(std::vector<PoolTask> tasks, std::size_t threads);
+
+#endif
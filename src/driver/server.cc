@@ -0,0 +1,299 @@
+#include "server.hh"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+// requests and responses are sequences of 64-bit numbers and length-prefixed strings, in the byte order
+//  of the machine both ends run on
+//  request:  optimize, unroll budget, source
+//  response: success, output, diagnostic count, and per diagnostic type, offset, length, line, column, message
+constexpr std::uint64_t maxText = 1 << 24;
+// texts are read this much at a time, so a claimed size costs memory only once the bytes arrive
+constexpr std::uint64_t textChunk = 1 << 16;
+// connections waiting for a handler thread; more stay in the listen backlog
+constexpr std::size_t maxWaiting = 64;
+// a connection that sends nothing for this long gives its handler thread back
+constexpr int idleSeconds = 10;
+
+void putNumber(std::string &message, std::uint64_t n) {
+    message.append(reinterpret_cast<const char *>(&n), sizeof(n));
+}
+void putText(std::string &message, std::string_view text) {
+    putNumber(message, text.size());
+    message += text;
+}
+
+bool readAll(int fd, char *data, std::size_t size) {
+    while (size) {
+        auto n = read(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+bool writeAll(int fd, const char *data, std::size_t size) {
+    while (size) {
+        auto n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+bool getNumber(int fd, std::uint64_t &n) {
+    return readAll(fd, reinterpret_cast<char *>(&n), sizeof(n));
+}
+bool getText(int fd, std::string &text) {
+    std::uint64_t size;
+    if (!getNumber(fd, size) || size > maxText) return false;
+    text.clear();
+    while (text.size() < size) {
+        auto done = text.size();
+        text.resize(done + std::min(size - done, textChunk));
+        if (!readAll(fd, text.data() + done, text.size() - done)) return false;
+    }
+    return true;
+}
+
+// whether the process at the other end of a connection runs as this user
+bool peerIsSelf(int fd) {
+    ucred peer;
+    socklen_t size = sizeof(peer);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size) == 0 && peer.uid == geteuid();
+}
+
+// without a runtime directory the socket goes in a directory in /tmp only its owner can enter, so no
+//  other user can bind the path first
+std::string fallbackSocketDirectory() {
+    return "/tmp/std20c-" + std::to_string(geteuid());
+}
+
+std::string defaultSocketPath() {
+    if (auto runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime) return std::string(runtime) + "/std20c.sock";
+    return fallbackSocketDirectory() + "/std20c.sock";
+}
+
+// creates `directory` if need be; false if it is not a directory of this user that nobody else can enter
+bool makePrivateDirectory(const std::string &directory, std::ostream &log) {
+    if (mkdir(directory.c_str(), 0700) < 0 && errno != EEXIST) {
+        log << "cannot create " << directory << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    struct stat status;
+    if (lstat(directory.c_str(), &status) < 0 || !S_ISDIR(status.st_mode) || status.st_uid != geteuid()
+        || (status.st_mode & 077)) {
+        log << directory << " is not a directory only this user can enter\n";
+        return false;
+    }
+    return true;
+}
+
+bool socketAddress(const std::string &path, sockaddr_un &address) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    return true;
+}
+
+int connectTo(const sockaddr_un &address) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// connections accepted and waiting for a handler thread
+struct ConnectionQueue {
+    std::mutex mutex;
+    std::condition_variable waiting, space;
+    std::deque<int> connections;
+};
+
+// the socket the signal handler removes
+char listeningOn[sizeof(sockaddr_un::sun_path)];
+
+void stopServing(int) {
+    unlink(listeningOn);
+    _exit(0);
+}
+
+// answers the requests of one client until it hangs up or goes quiet
+void answer(int connection, std::string &source, std::string &output, std::string &response) {
+    std::uint64_t optimize, unrollBudget;
+    while (getNumber(connection, optimize) && getNumber(connection, unrollBudget) && getText(connection, source)) {
+        CompileOptions options;
+        options.optimize = std::min<std::uint64_t>(optimize, 2);
+        options.unrollBudget = unrollBudget;
+        auto result = compile(source, options, output);
+        response.clear();
+        putNumber(response, result.success);
+        putText(response, output);
+        putNumber(response, result.diagnostics.size());
+        for (auto &diagnostic: result.diagnostics) {
+            putNumber(response, diagnostic.type);
+            putNumber(response, diagnostic.offset);
+            putNumber(response, diagnostic.length);
+            putNumber(response, diagnostic.line);
+            putNumber(response, diagnostic.column);
+            putText(response, diagnostic.message);
+        }
+        if (!writeAll(connection, response.data(), response.size())) break;
+    }
+    close(connection);
+}
+
+// one of the fixed set of handler threads: its buffers and arena outlive the connections it answers
+void handleConnections(ConnectionQueue &queue) {
+    std::string source, output, response;
+    while (true) {
+        int connection;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.waiting.wait(lock, [&] { return !queue.connections.empty(); });
+            connection = queue.connections.front();
+            queue.connections.pop_front();
+        }
+        queue.space.notify_one();
+        answer(connection, source, output, response);
+    }
+}
+
+int serve(const std::string &path, std::ostream &log) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)) {
+        log << "socket path too long: " << path << "\n";
+        return 1;
+    }
+    auto directory = path.substr(0, path.find_last_of('/'));
+    if (directory == fallbackSocketDirectory() && !makePrivateDirectory(directory, log)) return 1;
+    // a socket nobody accepts on is left over from a server that did not exit cleanly
+    if (int running = connectTo(address); running >= 0) {
+        close(running);
+        log << "a server is already listening on " << path << "\n";
+        return 1;
+    }
+    unlink(path.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0 || bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0
+        || listen(listener, SOMAXCONN) < 0) {
+        log << "cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::copy(path.begin(), path.end(), listeningOn);
+    std::signal(SIGINT, stopServing);
+    std::signal(SIGTERM, stopServing);
+
+    // builds the scanner's and parser's tables before the first request needs them
+    std::string warmUp;
+    compile("Number x = 1;\nprint(x);\n", CompileOptions{2}, warmUp);
+    log << "listening on " << path << std::endl;
+
+    // the handlers wait on the queue until the process exits, so it is never freed
+    auto &queue = *new ConnectionQueue;
+    auto handlers = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < handlers; i++) std::thread(handleConnections, std::ref(queue)).detach();
+    timeval idle{idleSeconds, 0};
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.space.wait(lock, [&] { return queue.connections.size() < maxWaiting; });
+        }
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            log << "cannot accept connections on " << path << ": " << std::strerror(errno) << "\n";
+            unlink(path.c_str());
+            return 1;
+        }
+        if (!peerIsSelf(connection)) {
+            log << "refused a connection from another user\n";
+            close(connection);
+            continue;
+        }
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+        setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &idle, sizeof(idle));
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.connections.push_back(connection);
+        }
+        queue.waiting.notify_one();
+    }
+}
+
+// a client thread's connection, kept for its next request and closed when the thread exits
+struct ServerConnection {
+    std::string path;
+    int fd = -1;
+    void drop() {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    ~ServerConnection() { drop(); }
+};
+thread_local ServerConnection serverConnection;
+
+// one request and its response on an open connection; nullopt if the exchange fails
+std::optional<CompileResult> exchange(int server, std::string_view source, const CompileOptions &options,
+                                      std::string &output) {
+    std::string request;
+    putNumber(request, options.optimize);
+    putNumber(request, options.unrollBudget);
+    putText(request, source);
+    CompileResult result{false, {}};
+    std::uint64_t success, diagnostics;
+    bool answered = writeAll(server, request.data(), request.size()) && getNumber(server, success)
+                    && getText(server, output) && getNumber(server, diagnostics);
+    for (std::uint64_t i = 0; answered && i < diagnostics; i++) {
+        std::uint64_t type, offset, length, line, column;
+        std::string message;
+        answered = getNumber(server, type) && getNumber(server, offset) && getNumber(server, length)
+                   && getNumber(server, line) && getNumber(server, column) && getText(server, message)
+                   && offset + length <= source.size();
+        if (answered) {
+            result.diagnostics.push_back(Diagnostic{static_cast<CompilerError::Type>(type), offset, length, line, column, message});
+        }
+    }
+    if (!answered) return std::nullopt;
+    result.success = success;
+    return result;
+}
+
+std::optional<CompileResult> compileOnServer(const std::string &path, std::string_view source,
+                                             const CompileOptions &options, std::string &output) {
+    sockaddr_un address;
+    if (source.size() > maxText || !socketAddress(path, address)) return std::nullopt;
+    auto &connection = serverConnection;
+    // a kept connection the server has since closed for being idle gets one fresh try
+    for (bool reused = connection.fd >= 0 && connection.path == path;; reused = false) {
+        if (!reused) {
+            connection.drop();
+            connection.fd = connectTo(address);
+            connection.path = path;
+            // a socket some other user serves could answer with anything
+            if (connection.fd >= 0 && !peerIsSelf(connection.fd)) connection.drop();
+            if (connection.fd < 0) return std::nullopt;
+        }
+        if (auto result = exchange(connection.fd, source, options, output)) return result;
+        connection.drop();
+        if (!reused) return std::nullopt;
+    }
+}
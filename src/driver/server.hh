@@ -0,0 +1,24 @@
+#ifndef SERVER_HH
+#define SERVER_HH
+#include <std20c/compile.hh>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// where --serve listens and --connect sends to unless given a path: $XDG_RUNTIME_DIR/std20c.sock,
+//  or std20c.sock in /tmp/std20c-<uid>, a directory only that user can enter
+std::string defaultSocketPath();
+
+// answers compile requests on a Unix socket at `path` until SIGINT or SIGTERM, which remove the socket;
+//  only processes of the same user may connect. A fixed set of threads, one per core, answers the
+//  connections; each keeps its buffers and arena across the requests it answers, and all of them share
+//  the compiler's tables built once at startup; problems are reported to `log`
+int serve(const std::string &path, std::ostream &log);
+
+// compiles `source` on the server listening at `path`, as compile() would; nullopt if none answers or
+//  it runs as another user. The calling thread keeps the connection open for its next request
+std::optional<CompileResult> compileOnServer(const std::string &path, std::string_view source,
+                                             const CompileOptions &options, std::string &output);
+
+#endif
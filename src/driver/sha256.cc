@@ -0,0 +1,85 @@
+#include "sha256.hh"
+
+constexpr std::uint32_t roundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+std::uint32_t rotateRight(std::uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void compressBlock(std::uint32_t state[8], const unsigned char *block) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = std::uint32_t(block[4 * i]) << 24 | std::uint32_t(block[4 * i + 1]) << 16
+             | std::uint32_t(block[4 * i + 2]) << 8 | std::uint32_t(block[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        auto s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        auto s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    auto a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        auto t1 = h + (rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25)) + ((e & f) ^ (~e & g)) + roundConstants[i] + w[i];
+        auto t2 = (rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(std::string_view data) {
+    auto bytes = reinterpret_cast<const unsigned char *>(data.data());
+    auto left = data.size();
+    size += left;
+    if (pendingSize) {
+        while (left && pendingSize < 64) {
+            pending[pendingSize++] = *bytes++;
+            left--;
+        }
+        if (pendingSize < 64) return;
+        compressBlock(state, pending);
+        pendingSize = 0;
+    }
+    for (; left >= 64; bytes += 64, left -= 64) compressBlock(state, bytes);
+    for (; left; left--) pending[pendingSize++] = *bytes++;
+}
+
+std::string Sha256::finish() {
+    // a 1 bit, zeros and the length in bits fill one or two last blocks
+    unsigned char last[128] = {};
+    for (std::size_t i = 0; i < pendingSize; i++) last[i] = pending[i];
+    last[pendingSize] = 0x80;
+    std::size_t lastSize = pendingSize < 56 ? 64 : 128;
+    std::uint64_t bits = size * 8;
+    for (int i = 0; i < 8; i++) last[lastSize - 1 - i] = bits >> (8 * i);
+    for (std::size_t i = 0; i < lastSize; i += 64) compressBlock(state, last + i);
+
+    const char *digits = "0123456789abcdef";
+    std::string hex;
+    for (auto word: state) {
+        for (int shift = 28; shift >= 0; shift -= 4) hex += digits[(word >> shift) & 0xf];
+    }
+    return hex;
+}
+
+std::string sha256(std::string_view data) {
+    Sha256 hash;
+    hash.update(data);
+    return hash.finish();
+}
@@ -0,0 +1,22 @@
+#ifndef SHA256_HH
+#define SHA256_HH
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// SHA-256 (FIPS 180-4) of everything given to update(), in pieces of any size
+struct Sha256 {
+    void update(std::string_view data);
+    // the digest as 64 lowercase hex digits; the hash cannot be updated afterwards
+    std::string finish();
+private:
+    std::uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    unsigned char pending[64];  // bytes not yet making up a whole block
+    std::size_t pendingSize = 0;
+    std::uint64_t size = 0;
+};
+
+std::string sha256(std::string_view data);
+
+#endif
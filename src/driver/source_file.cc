@@ -0,0 +1,55 @@
+#include "source_file.hh"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::~SourceFile() {
+    if (mapping) munmap(mapping, size);
+}
+
+bool SourceFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat file;
+    if (fstat(fd, &file) == 0 && S_ISREG(file.st_mode) && file.st_size > 0) {
+        auto address = mmap(nullptr, file.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            mapping = address;
+            size = file.st_size;
+            // the scanner reads the file once from front to back
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            close(fd);
+            return true;
+        }
+    }
+    return readAll(fd);
+}
+
+bool SourceFile::read(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return fd >= 0 && readAll(fd);
+}
+
+// reads `fd` to its end into the buffer and closes it; a file that shrinks meanwhile just ends early
+bool SourceFile::readAll(int fd) {
+    char chunk[65536];
+    while (true) {
+        auto n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        if (n == 0) break;
+        buffer.append(chunk, n);
+    }
+    close(fd);
+    return true;
+}
+
+std::string_view SourceFile::text() const {
+    if (mapping) return std::string_view(static_cast<const char *>(mapping), size);
+    return buffer;
+}
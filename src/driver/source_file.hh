@@ -0,0 +1,29 @@
+#ifndef SOURCE_FILE_HH
+#define SOURCE_FILE_HH
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// an input file mapped read-only into memory, so loading it copies nothing; files that cannot be mapped
+//  (pipes, /dev/stdin) are read into a buffer instead. Tokens and errors point into text() while it lives
+//  and, for a mapped file, while no other process truncates it: touching the lost pages raises SIGBUS
+class SourceFile {
+public:
+    SourceFile() = default;
+    ~SourceFile();
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+
+    // false if the file cannot be opened or read
+    bool open(const std::string &path);
+    // as open, but always copies the file, for files others may be rewriting while it is in use (--watch)
+    bool read(const std::string &path);
+    std::string_view text() const;
+private:
+    bool readAll(int fd);
+    void *mapping = nullptr;
+    std::size_t size = 0;
+    std::string buffer;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "watch.hh"
+#include "output_file.hh"
+#include "source_file.hh"
+#include "../codegen/emit.hh"
+#include "../document.hh"
+#include "../pipeline.hh"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <set>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+// a burst of saves is over once no event came for this long, or once it has lasted the longest
+constexpr int quietMilliseconds = 5;
+constexpr auto longestBurst = std::chrono::milliseconds(100);
+
+// editors save under hidden names before renaming them over the file
+bool isSource(const std::string &name) {
+    return name.size() > 4 && name[0] != '.' && name.compare(name.size() - 4, 4, ".s20") == 0;
+}
+
+std::set<std::string> sourcesIn(const std::string &dir) {
+    std::set<std::string> names;
+    std::error_code error;
+    for (auto &entry: std::filesystem::directory_iterator(dir, error)) {
+        auto name = entry.path().filename().string();
+        if (isSource(name) && entry.is_regular_file(error)) names.insert(name);
+    }
+    return names;
+}
+
+// adds the sources named by the events waiting on `fd` to `changed`; false once the directory is gone
+bool readEvents(int fd, std::set<std::string> &changed, bool &overflowed) {
+    alignas(inotify_event) char buffer[64 * 1024];
+    auto n = read(fd, buffer, sizeof(buffer));
+    if (n < 0) return errno == EINTR || errno == EAGAIN;
+    for (char *p = buffer; p < buffer + n;) {
+        auto event = reinterpret_cast<const inotify_event *>(p);
+        if (event->mask & IN_IGNORED) return false;
+        if (event->mask & IN_Q_OVERFLOW) overflowed = true;
+        if (event->len && isSource(event->name)) changed.insert(event->name);
+        p += sizeof(inotify_event) + event->len;
+    }
+    return true;
+}
+
+// brings the document of `name` up to date with the file and writes its output, or forgets it if the
+//  file is gone
+void recompile(const std::string &dir, const std::string &name, std::map<std::string, std::unique_ptr<Document>> &documents,
+               const WatchOptions &options, std::ostream &log) {
+    auto start = Clock::now();
+    SourceFile file;
+    // editors truncate files as they save them, which a mapping of the file would not survive
+    if (!file.read((std::filesystem::path(dir) / name).string())) {
+        if (documents.erase(name)) log << name << ": removed\n";
+        return;
+    }
+    auto &document = documents[name];
+    if (document) document->update(file.text());
+    else document = std::make_unique<Document>(file.text());
+
+    auto &text = document->text();
+    auto output = (std::filesystem::path(options.outdir) / std::filesystem::path(name).stem()).string() + ".std20";
+    bool compiled = false;
+    {
+        ArenaScope arena;
+        auto tryCompile = document->compile(options.optimize, options.unroll);
+        if (std::holds_alternative<CompilerError>(tryCompile)) {
+            log << name << ":" << formatDiagnostic(text, diagnosticOf(text, std::get<CompilerError>(tryCompile)));
+        } else {
+            OutputFile out;
+            compiled = out.open(output) && writeIR(out.descriptor(), std::get<IR>(tryCompile)) && out.commit();
+            if (!compiled) log << name << ": cannot write " << output << "\n";
+        }
+    }
+    auto milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    log << name << ": " << (compiled ? "compiled" : "failed") << " in " << std::fixed << std::setprecision(2)
+        << milliseconds << " ms (" << document->reparsed() << " of " << document->statements()
+        << " statements parsed again)" << std::endl;
+}
+
+int watch(const std::string &dir, const WatchOptions &options, std::ostream &log) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(options.outdir) && !std::filesystem::create_directories(options.outdir, error)) {
+        log << "cannot create " << options.outdir << ": " << error.message() << "\n";
+        return 1;
+    }
+    int events = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (events < 0 || inotify_add_watch(events, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) < 0) {
+        log << "cannot watch " << dir << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // the documents live outside any ArenaScope, every compilation gets one of its own
+    std::map<std::string, std::unique_ptr<Document>> documents;
+    for (auto &name: sourcesIn(dir)) recompile(dir, name, documents, options, log);
+    log << "watching " << dir << std::endl;
+
+    pollfd waiting{events, POLLIN, 0};
+    while (true) {
+        if (poll(&waiting, 1, -1) < 0 && errno != EINTR) {
+            log << "cannot watch " << dir << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        std::set<std::string> changed;
+        bool overflowed = false;
+        auto burst = Clock::now();
+        do {
+            if (!readEvents(events, changed, overflowed)) {
+                log << "stopped watching " << dir << ": it is gone\n";
+                return 1;
+            }
+        } while (Clock::now() - burst < longestBurst && poll(&waiting, 1, quietMilliseconds) > 0);
+        // events were lost: every file may have changed or gone
+        if (overflowed) {
+            changed = sourcesIn(dir);
+            for (auto &[name, document]: documents) changed.insert(name);
+        }
+        for (auto &name: changed) recompile(dir, name, documents, options, log);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef WATCH_HH
+#define WATCH_HH
+#include "../optimization/optimizer.hh"
+#include <ostream>
+#include <string>
+
+struct WatchOptions {
+    size_t optimize = 0;
+    UnrollCostModel unroll;
+    std::string outdir;     // where <name>.s20 is written to as <name>.std20
+};
+
+// compiles every .s20 file in `dir`, then again whenever one is saved, until interrupted. A burst of saves
+//  is compiled once it has been quiet for a few milliseconds; every file keeps a Document (see
+//  document.hh), so a save scans and parses again only the statements it changed. Outputs are replaced
+//  atomically; diagnostics and how long each file took go to `log`
+int watch(const std::string &dir, const WatchOptions &options, std::ostream &log);
+
+#endif
@@ -1,18 +1,20 @@
 #include <std20c/error_message.hh>
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <tuple>
 #include <utility>
 
 const char* BOLD_RED = "\033[1;31m";
 const char* DEFAULT = "\e[0m";
 
-std::tuple<size_t, size_t> getLnCol(const std::string &contents, std::string::const_iterator it) {
+std::tuple<size_t, size_t> getLnCol(std::string_view contents, const char *it) {
     size_t line = 1;
     size_t col = 1;
-    for (auto iter = contents.begin(); iter != it; ++iter) {
+    for (auto iter = contents.data(); iter != it; ++iter) {
         if (*iter == '\n') {
             ++line;
             col = 1;
@@ -22,20 +24,36 @@ std::tuple<size_t, size_t> getLnCol(const std::string &contents, std::string::co
     }
     return std::make_tuple(line, col);
 }
-std::pair<std::string::const_iterator, std::string::const_iterator> getSurroundings(const std::string &contents, std::string::const_iterator it, size_t length) {
+
+LineIndex::LineIndex(std::string_view contents): begin(contents.data()), lineStarts{0} {
+    auto end = contents.data() + contents.size();
+    for (auto it = begin; (it = static_cast<const char *>(std::memchr(it, '\n', end - it))); it++) {
+        lineStarts.push_back(it + 1 - begin);
+    }
+}
+
+std::tuple<size_t, size_t> LineIndex::lineAndColumn(const char *it) const {
+    size_t offset = it - begin;
+    // the last line starting at or before `it`
+    size_t line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+    return std::make_tuple(line, offset - lineStarts[line - 1] + 1);
+}
+std::pair<const char *, const char *> getSurroundings(std::string_view contents, const char *it, size_t length) {
     const size_t maxChars = 10;
     auto start = it;
     auto end = it + length;
+    // the source may be a file mapping, which has nothing readable past its end
+    auto last = contents.data() + contents.size();
     // Move start iterator back up to max_chars or until a newline is found
     for (size_t i = 0; i < maxChars; start--) {
-        if (*start == '\n' || start == contents.begin()) {
+        if ((start != last && *start == '\n') || start == contents.data()) {
             break;
         }
     }
-    if (*start == '\n') start++;
+    if (start != last && *start == '\n') start++;
     
     // Move end iterator forward up to max_chars or until a newline is found
-    for (size_t i = 0; i < maxChars && end != contents.end(); end++) {
+    for (size_t i = 0; i < maxChars && end != last; end++) {
         if (*end == '\n') {
             break;
         }
@@ -43,7 +61,12 @@ std::pair<std::string::const_iterator, std::string::const_iterator> getSurroundi
     return std::make_pair(start, end);
 }
 
-int generateErrorMessage(const std::string &contents, CompilerError error) {
+int generateErrorMessage(std::ostream &os, std::string_view contents, CompilerError error) {
+    auto [ln, col] = getLnCol(contents, error.errorPosition);
+    return generateErrorMessage(os, contents, error, ln, col);
+}
+
+int generateErrorMessage(std::ostream &os, std::string_view contents, CompilerError error, size_t ln, size_t col) {
     auto errorType = [&]() {
         switch (error.type) {
         case CompilerError::SCAN:
@@ -59,9 +82,7 @@ int generateErrorMessage(const std::string &contents, CompilerError error) {
         };
     }();
 
-    // find ln and col of contents
-    auto [ln, col] = getLnCol(contents, error.errorPosition);
-    std::cerr << ln << ":" << col << ": " << BOLD_RED << errorType << ": " << DEFAULT << error.errorMessage << "\n";
+    os << ln << ":" << col << ": " << BOLD_RED << errorType << ": " << DEFAULT << error.errorMessage << "\n";
 
     auto [beginIt, endIt] = getSurroundings(contents, error.errorPosition, error.errorLength);
 
@@ -72,9 +93,13 @@ int generateErrorMessage(const std::string &contents, CompilerError error) {
 
     std::string strLn = std::to_string(ln);
     size_t headerSize = std::max(strLn.size(), static_cast<size_t>(5));
-    std::cerr << std::setw(headerSize) << std::setfill(' ') << strLn;
-    std::cerr << " | " << beginContext << BOLD_RED << errorContext << DEFAULT << endContext << "\n";
-    std::cerr << std::setw(headerSize) << std::setfill(' ') << "";
-    std::cerr << " | " << std::setw(beginContext.size()) << "" << BOLD_RED << std::setw(errorContext.size()) << std::setfill('^') << "" << DEFAULT << "\n";
+    os << std::setw(headerSize) << std::setfill(' ') << strLn;
+    os << " | " << beginContext << BOLD_RED << errorContext << DEFAULT << endContext << "\n";
+    os << std::setw(headerSize) << std::setfill(' ') << "";
+    os << " | " << std::setw(beginContext.size()) << "" << BOLD_RED << std::setw(errorContext.size()) << std::setfill('^') << "" << DEFAULT << "\n";
     return 1;
 }
+
+int generateErrorMessage(std::string_view contents, CompilerError error) {
+    return generateErrorMessage(std::cerr, contents, error);
+}
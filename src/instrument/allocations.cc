@@ -0,0 +1,8 @@
+#include "allocations.hh"
+
+bool countAllocations = false;
+thread_local AllocationCount allocatedOnThread;
+
+AllocationCount threadAllocations() {
+    return allocatedOnThread;
+}
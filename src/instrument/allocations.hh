@@ -0,0 +1,17 @@
+#ifndef ALLOCATIONS_HH
+#define ALLOCATIONS_HH
+#include <cstddef>
+
+struct AllocationCount {
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;      // as requested from operator new
+};
+
+// operator new counts the allocations of each thread while this is set (off by default, as counting is
+//  only needed for -ftime-report); the replacement operators live in count_new.cc
+extern bool countAllocations;
+
+// allocations the calling thread has made while counting was on
+AllocationCount threadAllocations();
+
+#endif
@@ -0,0 +1,42 @@
+#include "allocations.hh"
+#include <cstdlib>
+#include <new>
+
+extern thread_local AllocationCount allocatedOnThread;
+
+// replacements for the global allocation functions: malloc/free as the default ones, plus counting;
+//  the array, nothrow and sized forms forward to these. Only the executables link them, libstd20c
+//  leaves the host's operator new alone
+void *operator new(std::size_t size) {
+    if (countAllocations) {
+        allocatedOnThread.allocations++;
+        allocatedOnThread.bytes += size;
+    }
+    if (auto p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return operator new(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
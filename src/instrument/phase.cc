@@ -0,0 +1,107 @@
+#include "phase.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+constexpr std::size_t noPhase = -1;
+
+thread_local TimeReport *activeReport = nullptr;
+thread_local std::size_t runningPhase = noPhase;    // innermost phase running on this thread
+
+double wallClock() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+double threadCPUClock() {
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+void setTimeReport(TimeReport *report) {
+    activeReport = report;
+    runningPhase = noPhase;
+}
+
+PhaseScope::PhaseScope(const char *name): trace(name, "phase"), report(activeReport) {
+    if (!report) return;
+    auto path = runningPhase == noPhase ? std::string(name) : report->phases[runningPhase].path + "/" + name;
+    auto depth = runningPhase == noPhase ? 0 : report->phases[runningPhase].depth + 1;
+    for (phase = 0; phase < report->phases.size() && report->phases[phase].path != path; phase++) {}
+    if (phase == report->phases.size()) report->phases.push_back(PhaseTiming{path, depth});
+    parentPhase = runningPhase;
+    runningPhase = phase;
+    allocationStart = threadAllocations();
+    cpuStart = threadCPUClock();
+    wallStart = wallClock();
+}
+
+PhaseScope::~PhaseScope() {
+    if (!report) return;
+    auto wallEnd = wallClock();
+    auto cpuEnd = threadCPUClock();
+    auto allocationEnd = threadAllocations();
+    auto &timing = report->phases[phase];
+    timing.runs++;
+    timing.wallSeconds += wallEnd - wallStart;
+    timing.cpuSeconds += cpuEnd - cpuStart;
+    timing.allocated.allocations += allocationEnd.allocations - allocationStart.allocations;
+    timing.allocated.bytes += allocationEnd.bytes - allocationStart.bytes;
+    runningPhase = parentPhase;
+}
+
+void mergeTimeReport(TimeReport &into, const TimeReport &from) {
+    for (auto &timing: from.phases) {
+        auto same = std::find_if(into.phases.begin(), into.phases.end(), [&](auto &t) { return t.path == timing.path; });
+        if (same == into.phases.end()) {
+            // after the parent's last sub-phase, so the order still shows the nesting
+            auto slash = timing.path.rfind('/');
+            auto position = into.phases.end();
+            if (slash != std::string::npos) {
+                auto parent = timing.path.substr(0, slash);
+                for (auto p = into.phases.begin(); p != into.phases.end(); p++) {
+                    if (p->path == parent || p->path.rfind(parent + "/", 0) == 0) position = p + 1;
+                }
+            }
+            into.phases.insert(position, timing);
+            continue;
+        }
+        same->runs += timing.runs;
+        same->wallSeconds += timing.wallSeconds;
+        same->cpuSeconds += timing.cpuSeconds;
+        same->allocated.allocations += timing.allocated.allocations;
+        same->allocated.bytes += timing.allocated.bytes;
+    }
+}
+
+std::string nameOf(const PhaseTiming &timing) {
+    return timing.path.substr(timing.path.rfind('/') + 1);
+}
+
+void printTimeReport(std::ostream &os, const TimeReport &report) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%10s %10s %10s %12s  %s\n", "wall ms", "cpu ms", "allocs", "bytes", "phase");
+    os << line;
+    for (auto &timing: report.phases) {
+        std::snprintf(line, sizeof(line), "%10.3f %10.3f %10zu %12zu  %s%s", timing.wallSeconds * 1e3, timing.cpuSeconds * 1e3,
+                      timing.allocated.allocations, timing.allocated.bytes, std::string(timing.depth * 2, ' ').c_str(),
+                      nameOf(timing).c_str());
+        os << line;
+        if (timing.runs > 1) os << " (" << timing.runs << " runs)";
+        os << "\n";
+    }
+}
+
+void printTimeReportJSON(std::ostream &os, const TimeReport &report) {
+    // phase names are fixed identifiers, nothing in them needs escaping
+    os << "{\"phases\": [";
+    for (size_t i = 0; i < report.phases.size(); i++) {
+        auto &timing = report.phases[i];
+        char numbers[200];
+        std::snprintf(numbers, sizeof(numbers), "\"runs\": %zu, \"wall_ms\": %.6f, \"cpu_ms\": %.6f, \"allocations\": %zu, \"bytes\": %zu",
+                      timing.runs, timing.wallSeconds * 1e3, timing.cpuSeconds * 1e3, timing.allocated.allocations, timing.allocated.bytes);
+        os << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << nameOf(timing) << "\", \"path\": \"" << timing.path
+           << "\", \"depth\": " << timing.depth << ", " << numbers << "}";
+    }
+    os << "\n]}\n";
+}
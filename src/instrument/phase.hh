@@ -0,0 +1,50 @@
+#ifndef PHASE_HH
+#define PHASE_HH
+#include "allocations.hh"
+#include "trace.hh"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// time and memory spent in one phase, summed over every time it ran
+struct PhaseTiming {
+    std::string path;           // names of the enclosing phases and this one, joined by '/'
+    std::size_t depth;
+    std::size_t runs = 0;
+    double wallSeconds = 0;
+    double cpuSeconds = 0;      // of the thread running the phase
+    AllocationCount allocated;  // including the allocations of nested phases
+};
+struct TimeReport {
+    std::vector<PhaseTiming> phases;    // in the order they first started
+};
+
+// phases that start on the calling thread are added to the report (nullptr: they are not measured)
+void setTimeReport(TimeReport *);
+
+// measures the enclosing scope as a phase of the calling thread's report, nested in the phases
+//  already running on the thread, and traces it while tracing; costs a thread-local check and an
+//  atomic load when neither is on
+struct PhaseScope {
+    explicit PhaseScope(const char *name);
+    ~PhaseScope();
+    PhaseScope(const PhaseScope &) = delete;
+    PhaseScope &operator=(const PhaseScope &) = delete;
+private:
+    TraceScope trace;
+    TimeReport *report;
+    std::size_t phase;
+    std::size_t parentPhase;
+    double wallStart, cpuStart;
+    AllocationCount allocationStart;
+};
+
+// adds the phases of `from` to `into`, matching them by path (e.g. the reports of several threads)
+void mergeTimeReport(TimeReport &into, const TimeReport &from);
+
+// the report as a table (times in ms), or as one JSON object with a `phases` array
+void printTimeReport(std::ostream &, const TimeReport &);
+void printTimeReportJSON(std::ostream &, const TimeReport &);
+
+#endif
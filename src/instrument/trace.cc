@@ -0,0 +1,107 @@
+#include "trace.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+    std::string name;
+    const char *category;
+    double begin;       // µs since the trace started
+    double duration;
+};
+// events of one thread, appended to without locking by that thread only
+struct ThreadTrace {
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+std::atomic<bool> tracing{false};
+std::chrono::steady_clock::time_point traceStart;
+std::mutex threadsMutex;
+std::vector<std::unique_ptr<ThreadTrace>> threads;
+thread_local ThreadTrace *threadTrace = nullptr;
+
+double traceClock() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+ThreadTrace &currentThreadTrace() {
+    if (!threadTrace) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threads.push_back(std::make_unique<ThreadTrace>());
+        threads.back()->name = "thread " + std::to_string(threads.size() - 1);
+        threadTrace = threads.back().get();
+    }
+    return *threadTrace;
+}
+
+void startTrace() {
+    traceStart = std::chrono::steady_clock::now();
+    tracing = true;
+}
+
+bool isTracing() {
+    return tracing.load(std::memory_order_relaxed);
+}
+
+void nameTraceThread(const std::string &name) {
+    if (isTracing()) currentThreadTrace().name = name;
+}
+
+TraceScope::TraceScope(const char *name, const char *category): active(isTracing()), name(name), category(category) {
+    if (active) begin = traceClock();
+}
+
+TraceScope::TraceScope(const std::string &name, const char *category): active(isTracing()), name(nullptr), category(category) {
+    if (!active) return;
+    dynamicName = name;
+    begin = traceClock();
+}
+
+TraceScope::~TraceScope() {
+    if (!active) return;
+    auto end = traceClock();
+    currentThreadTrace().events.push_back({name ? name : dynamicName, category, begin, end - begin});
+}
+
+std::string escapeJSON(const std::string &text) {
+    std::string escaped;
+    for (unsigned char c: text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+bool writeTrace(const std::string &path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    const char *separator = "\n";
+    for (size_t tid = 0; tid < threads.size(); tid++) {
+        out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"" << escapeJSON(threads[tid]->name) << "\"}}";
+        separator = ",\n";
+        for (auto &event: threads[tid]->events) {
+            char times[80];
+            std::snprintf(times, sizeof(times), "\"ts\": %.3f, \"dur\": %.3f", event.begin, event.duration);
+            out << separator << "{\"name\": \"" << escapeJSON(event.name) << "\", \"cat\": \"" << event.category
+                << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid << ", " << times << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
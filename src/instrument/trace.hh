@@ -0,0 +1,29 @@
+#ifndef TRACE_HH
+#define TRACE_HH
+#include <string>
+
+// starts recording trace events on every thread; until then scopes cost one atomic load
+void startTrace();
+bool isTracing();
+// the name the calling thread is shown under (threads are "thread <n>" otherwise)
+void nameTraceThread(const std::string &);
+// writes what was recorded as Chrome trace-event JSON (for Perfetto or chrome://tracing); all threads
+//  that recorded events must have finished their scopes; false if the file cannot be written
+bool writeTrace(const std::string &path);
+
+// records the enclosing scope as one complete event on the calling thread
+struct TraceScope {
+    TraceScope(const char *name, const char *category);
+    TraceScope(const std::string &name, const char *category);
+    ~TraceScope();
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+private:
+    bool active;
+    const char *name;
+    std::string dynamicName;    // for names that do not live as long as the trace
+    const char *category;
+    double begin;
+};
+
+#endif
@@ -1,93 +1,346 @@
-#include <std20c/compilation.hh>
-#include <std20c/error_message.hh>
-#include <std20c/language.hh>
-#include "optimization/optimizer.hh"
-#include "scan/tokenize.hh"
-#include "parse/parser.hh"
-#include "analysis/semantics.hh"
-#include "codegen/lower.hh"
-#include "debug.hh"
-#include <cassert>
-#include <fstream>
+#include <std20c/compile.hh>
+#include "pipeline.hh"
+#include "codegen/emit.hh"
+#include "instrument/phase.hh"
+#include "instrument/trace.hh"
+#include "driver/cache.hh"
+#include "driver/output_file.hh"
+#include "driver/pool.hh"
+#include "driver/server.hh"
+#include "driver/source_file.hh"
+#include "driver/watch.hh"
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <ostream>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <variant>
 #include <vector>
 
-std::variant<IR, CompilerError> compile(const std::string &code, size_t optimize) {
-    auto tryScan = maximalMunch(code);
-    if (std::holds_alternative<CompilerError>(tryScan)) {
-        return std::get<CompilerError>(tryScan);
-    }
-    auto tryParse = earleyParser(std::get<std::vector<Token>>(tryScan));
-    if (std::holds_alternative<CompilerError>(tryParse)) {
-        return std::get<CompilerError>(tryParse);
-    }
-    auto &parseTree = std::get<Tree>(tryParse);
-    auto tryAnalyze = generateSymbolTable(parseTree);
-    if (std::holds_alternative<CompilerError>(tryAnalyze)) {
-        return std::get<CompilerError>(tryAnalyze);
-    }
-    auto tryCodeGen = generateIR(std::get<SymbolTable>(tryAnalyze), parseTree);
-    // in current implementation, generateIR is no fail
+struct DriverOptions {
+    std::string executable;
+    size_t optimize = 0;
+    UnrollCostModel unroll;
+    bool stats = false;
+    bool streaming = false;     // -O0 a statement at a time, see streamIR in pipeline.hh
+    size_t parseThreads = 0;    // -fparallel-parse, see parallelEarleyParser in parse/parser.hh
+    bool namedDiagnostics = false;  // diagnostics start with the input's name, for batches
+    std::optional<std::string> server;  // socket of the server to compile on, see driver/server.hh
+    std::optional<std::string> cacheDir;    // see driver/cache.hh
+};
+
+// every diagnostic of `infile`, in order
+void printDiagnostics(const std::string &infile, std::string_view contents, const std::vector<Diagnostic> &diagnostics,
+                      const DriverOptions &options, std::ostream &log) {
+    for (auto &diagnostic: diagnostics) {
+        if (options.namedDiagnostics) log << infile << ":";
+        log << formatDiagnostic(contents, diagnostic);
+    }
+}
+
+// compiles `contents` with streamIR, writing each statement to `outfile` as it is lowered
+int streamFile(const std::string &infile, std::string_view contents, const std::string &outfile,
+               const DriverOptions &options, std::ostream &log) {
+    OutputFile out;
+    if (!out.open(outfile)) {
+        log << options.executable << ": cannot write " << outfile << "\n";
+        return 1;
+    }
+    IRWriter writer(out.descriptor());
+    auto errors = streamIR(contents, [&](const Instructions &instructions) {
+        PhaseScope phase("emit");
+        return writer.write(instructions);
+    });
+    if (!errors.empty()) {
+        printDiagnostics(infile, contents, diagnosticsOf(contents, errors), options, log);
+        return 1;
+    }
+    if (!writer.finish() || !out.commit()) {
+        log << options.executable << ": cannot write " << outfile << "\n";
+        return 1;
+    }
+    if (options.stats) {
+        if (options.namedDiagnostics) log << infile << ":\n";
+        log << options.executable << ": -fstats: no optimization passes run at -O0\n";
+    }
+    return 0;
+}
+
+// compiles one input into `outfile`; its diagnostics and -fstats report go to `log`; returns the exit status
+int compileFile(const std::string &infile, const std::string &outfile, const DriverOptions &options, std::ostream &log) {
+    TraceScope trace(infile, "file");
+    SourceFile file;
+    if (![&] { PhaseScope phase("read"); return file.open(infile); }()) {
+        log << options.executable << ": cannot find " << infile << ": No such file or directory\n";
+        return 1;
+    }
+    auto contents = file.text();
+    if (options.streaming) return streamFile(infile, contents, outfile, options, log);
 
-    if (optimize) {
-        std::cout << "Note: optimization is still experimental (i.e. conditional statements do not work)" << std::endl;
-        return optimizer(tryCodeGen);
+    // the compilation comes from the cache, else the server, else is done here; -fstats needs the
+    //  optimizer to run here, so it does not look in the cache
+    CompileOptions flags;
+    flags.optimize = options.optimize;
+    flags.unrollBudget = options.unroll.sizeBudget;
+    std::optional<OptimizationStats> stats;
+    if (options.stats) stats.emplace();
+    std::optional<CompileResult> result;
+    std::optional<std::string> key;
+    std::string output;
+    ArenaScope arena;
+    std::optional<IR> ir;
+    if (options.cacheDir) {
+        PhaseScope phase("cache");
+        key = cacheKey(contents, flags);
+        if (!stats) result = lookupCache(*options.cacheDir, *key, contents, output);
+    }
+    bool cached = result.has_value();
+    if (!result && options.server) {
+        result = compileOnServer(*options.server, contents, flags, output);
+    }
+    if (!result) {
+        std::vector<CompilerError> errors;
+        auto tryCompile = compileIR(contents, options.optimize, options.unroll, stats ? &*stats : nullptr, options.parseThreads,
+                                    &errors);
+        if (std::holds_alternative<CompilerError>(tryCompile)) {
+            result = CompileResult{false, diagnosticsOf(contents, errors)};
+        } else {
+            result = CompileResult{true, {}};
+            ir = std::move(std::get<IR>(tryCompile));
+        }
     }
-    return tryCodeGen;
-} 
+
+    if (result->success) {
+        PhaseScope phase("emit");
+        // the cache keeps a copy of the text; otherwise it goes straight from the IR into the file
+        if (ir && key) {
+            output.reserve(emittedSize(*ir) + 1);
+            emitIR(*ir, output);
+            output += '\n';
+        }
+        OutputFile out;
+        bool written = out.open(outfile) && (ir && !key ? writeIR(out.descriptor(), *ir) : writeText(out.descriptor(), output))
+                       && out.commit();
+        if (!written) {
+            log << options.executable << ": cannot write " << outfile << "\n";
+            return 1;
+        }
+    }
+    if (key && !cached) {
+        PhaseScope phase("store");
+        storeCache(*options.cacheDir, *key, *result, output);
+    }
+    if (!result->success) {
+        printDiagnostics(infile, contents, result->diagnostics, options, log);
+        return 1;
+    }
+    if (stats) {
+        if (options.namedDiagnostics) log << infile << ":\n";
+        if (options.optimize) printOptimizationStats(log, *stats);
+        else log << options.executable << ": -fstats: no optimization passes run at -O0\n";
+    }
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
-    std::string executable = argv[0];
+    DriverOptions options;
+    options.executable = argv[0];
+    auto &executable = options.executable;
 
-    std::optional<std::string> infile;
-    std::string outfile = "a.out";
+    std::vector<std::string> infiles;
+    std::optional<std::string> outfile;
+    std::optional<std::string> outdir;
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
 
-    size_t optimize = 0;
-    
+    std::optional<TimeReport> timeReport;
+    bool timeReportJSON = false;
+    std::optional<std::string> traceFile;
+    std::optional<std::string> serveOn;
+    std::optional<std::string> watchDir;
+    bool parallelParse = false;
 
     for (int i = 1; i < argc; i++) {
         std::string str = argv[i];
         if (str == "-O0") {
-            optimize = 0;
+            options.optimize = 0;
         } else if (str == "-O1") {
-            optimize = 1;
+            options.optimize = 1;
         } else if (str == "-O2") {
-            optimize = 2;
-        } else if (str == "-o") {
+            options.optimize = 2;
+        } else if (str.rfind("-funroll-budget=", 0) == 0) {
+            auto value = str.substr(str.find('=') + 1);
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << executable << ": invalid instruction count in `" << str << "`\n";
+                return 1;
+            }
+            options.unroll.sizeBudget = std::stoul(value);
+        } else if (str.rfind("-j", 0) == 0 && str.size() > 2) {
+            auto value = str.substr(2);
+            if (value.find_first_not_of("0123456789") != std::string::npos || std::stoul(value) == 0) {
+                std::cerr << executable << ": invalid thread count in `" << str << "`\n";
+                return 1;
+            }
+            jobs = std::stoul(value);
+        } else if (str == "-ftime-report" || str == "-ftime-report=json") {
+            timeReport.emplace();
+            timeReportJSON = str == "-ftime-report=json";
+        } else if (str == "-fstats") {
+            options.stats = true;
+        } else if (str == "-fstreaming") {
+            options.streaming = true;
+        } else if (str == "-fparallel-parse") {
+            parallelParse = true;
+        } else if (str == "--serve" || str.rfind("--serve=", 0) == 0) {
+            serveOn = str.size() > 8 ? str.substr(8) : defaultSocketPath();
+        } else if (str == "--connect" || str.rfind("--connect=", 0) == 0) {
+            options.server = str.size() > 10 ? str.substr(10) : defaultSocketPath();
+        } else if (str.rfind("--trace=", 0) == 0 && str.size() > 8) {
+            traceFile = str.substr(8);
+        } else if (str == "-o" || str == "--outdir" || str == "--cache-dir" || str == "--watch") {
             if (i+1 < argc) {
-                outfile = argv[++i];
+                (str == "-o" ? outfile : str == "--outdir" ? outdir : str == "--watch" ? watchDir : options.cacheDir) = argv[++i];
             } else {
                 std::cerr << executable << ": missing filename after `" << str << "`\n";
                 return 1;
             }
-        } else if (!infile.has_value() && str.find('.') != std::string::npos) {
-            infile = str;
+        } else if (str.find('.') != std::string::npos) {
+            infiles.push_back(str);
         } else {
             std::cerr << executable << ": unrecognized command-line option `" << str << "`\n";
             return 1;
         }
     }
-    if (!infile.has_value()) {
+    if (serveOn) {
+        if (!infiles.empty()) {
+            std::cerr << executable << ": `--serve` takes no input files\n";
+            return 1;
+        }
+        return serve(*serveOn, std::cerr);
+    }
+    if (watchDir) {
+        if (!infiles.empty()) {
+            std::cerr << executable << ": `--watch` takes no input files\n";
+            return 1;
+        }
+        if (outfile || options.stats || options.streaming || options.server || options.cacheDir || timeReport || traceFile) {
+            std::cerr << executable << ": `--watch` only takes `-O`, `-funroll-budget` and `--outdir`\n";
+            return 1;
+        }
+        return watch(*watchDir, WatchOptions{options.optimize, options.unroll, outdir.value_or(*watchDir)}, std::cerr);
+    }
+    if (infiles.empty()) {
         std::cerr << executable << ": no input files\n";
         return 1;
     }
-
-    std::ifstream file(*infile);
-    if (!file) {
-        std::cerr << executable << ": cannot find " << *infile << ": No such file or directory\n";
+    if (infiles.size() > 1 && !outdir) {
+        std::cerr << executable << ": several input files need `--outdir`\n";
+        return 1;
+    }
+    if (options.server && (options.stats || timeReport || traceFile)) {
+        std::cerr << executable << ": `--connect` cannot be combined with `-fstats`, `-ftime-report` or `--trace`\n";
         return 1;
     }
-    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (options.streaming && options.optimize) {
+        std::cerr << executable << ": `-fstreaming` only compiles at -O0\n";
+        return 1;
+    }
+    if (options.streaming && (options.server || options.cacheDir)) {
+        std::cerr << executable << ": `-fstreaming` cannot be combined with `--connect` or `--cache-dir`\n";
+        return 1;
+    }
+    if (outfile && outdir) {
+        std::cerr << executable << ": `-o` cannot be combined with `--outdir`\n";
+        return 1;
+    }
+
+    // with --outdir, every input is written to <outdir>/<name without extension>.std20
+    std::vector<std::string> outfiles;
+    std::map<std::string, std::string> writtenBy;
+    for (auto &infile: infiles) {
+        if (!outdir) {
+            outfiles.push_back(outfile.value_or("a.out"));
+            continue;
+        }
+        auto output = (std::filesystem::path(*outdir) / std::filesystem::path(infile).stem()).string() + ".std20";
+        if (writtenBy.count(output)) {
+            std::cerr << executable << ": " << writtenBy.at(output) << " and " << infile << " would both be written to " << output << "\n";
+            return 1;
+        }
+        writtenBy.emplace(output, infile);
+        outfiles.push_back(output);
+    }
+    std::error_code error;
+    for (auto &dir: {outdir, options.cacheDir}) {
+        if (dir && !std::filesystem::is_directory(*dir) && !std::filesystem::create_directories(*dir, error)) {
+            std::cerr << executable << ": cannot create " << *dir << ": " << error.message() << "\n";
+            return 1;
+        }
+    }
 
-    auto tryCompile = compile(contents, optimize);
-    if (std::holds_alternative<CompilerError>(tryCompile)) {
-        return generateErrorMessage(contents, std::get<CompilerError>(tryCompile));
-    }
-    std::ofstream out;
-    out.open(outfile);
-    out << std::get<IR>(tryCompile) << std::endl;
-}
\ No newline at end of file
+    if (timeReport) countAllocations = true;
+    if (traceFile) {
+        startTrace();
+        nameTraceThread("main");
+    }
+
+    options.namedDiagnostics = outdir.has_value();
+    // the threads not busy with other inputs parse each one
+    if (parallelParse) options.parseThreads = std::max<size_t>(1, jobs / std::min(jobs, infiles.size()));
+    int status = 0;
+    if (infiles.size() == 1) {
+        if (timeReport) setTimeReport(&*timeReport);
+        status = compileFile(infiles[0], outfiles[0], options, std::cerr);
+        setTimeReport(nullptr);
+    } else {
+        // workers write each file's diagnostics to its own log, printed in input order as soon as the
+        //  files before it are done
+        auto threads = std::min(jobs, infiles.size());
+        std::vector<std::ostringstream> logs(infiles.size());
+        std::vector<int> statuses(infiles.size());
+        std::vector<TimeReport> reports(threads);
+        std::vector<bool> done(infiles.size());
+        std::mutex doneMutex;
+        std::condition_variable doneChanged;
+
+        std::vector<PoolTask> tasks;
+        for (size_t i = 0; i < infiles.size(); i++) {
+            tasks.push_back([&, i](size_t worker) {
+                if (timeReport) setTimeReport(&reports[worker]);
+                statuses[i] = compileFile(infiles[i], outfiles[i], options, logs[i]);
+                setTimeReport(nullptr);
+                std::lock_guard<std::mutex> lock(doneMutex);
+                done[i] = true;
+                doneChanged.notify_all();
+            });
+        }
+        std::thread pool([&] { runWorkStealing(std::move(tasks), threads); });
+        for (size_t i = 0; i < infiles.size(); i++) {
+            {
+                std::unique_lock<std::mutex> lock(doneMutex);
+                doneChanged.wait(lock, [&] { return done[i]; });
+            }
+            std::cerr << logs[i].str();
+            if (statuses[i]) status = 1;
+        }
+        pool.join();
+        if (timeReport) {
+            for (auto &report: reports) mergeTimeReport(*timeReport, report);
+        }
+    }
+
+    if (traceFile && !writeTrace(*traceFile)) {
+        std::cerr << executable << ": cannot write " << *traceFile << "\n";
+        return 1;
+    }
+    if (timeReport && !status) {
+        if (timeReportJSON) printTimeReportJSON(std::cerr, *timeReport);
+        else printTimeReport(std::cerr, *timeReport);
+    }
+    return status;
+}
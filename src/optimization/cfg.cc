@@ -0,0 +1,112 @@
+#include "cfg.hh"
+#include <map>
+#include <set>
+
+std::optional<std::string> labelOf(const Instruction &ins) {
+    if (!std::holds_alternative<GenericReadInstruction>(ins)) return std::nullopt;
+    auto &list = std::get<GenericReadInstruction>(ins).instruction;
+    if (std::get<std::string>(list.at(0)) != "label") return std::nullopt;
+    return std::get<std::string>(list.at(1));
+}
+
+std::optional<std::string> jumpTargetOf(const Instruction &ins) {
+    if (!std::holds_alternative<GenericReadInstruction>(ins)) return std::nullopt;
+    auto &list = std::get<GenericReadInstruction>(ins).instruction;
+    if (std::get<std::string>(list.at(0)).rfind("jmp", 0) != 0) return std::nullopt;
+    return std::get<std::string>(list.at(1));
+}
+
+bool comparesIdenticalImmediates(const Instruction &ins) {
+    auto &list = std::get<GenericReadInstruction>(ins).instruction;
+    return list.size() == 4
+        && std::holds_alternative<std::string>(list[2]) && std::holds_alternative<std::string>(list[3])
+        && std::get<std::string>(list[2]) == std::get<std::string>(list[3]);
+}
+
+bool isUnconditionalJump(const Instruction &ins) {
+    if (!jumpTargetOf(ins)) return false;
+    auto &opcode = std::get<std::string>(std::get<GenericReadInstruction>(ins).instruction[0]);
+    if (opcode == "jmp") return true;
+    return (opcode == "jmpe" || opcode == "jmple" || opcode == "jmpge") && comparesIdenticalImmediates(ins);
+}
+
+bool isNeverTakenJump(const Instruction &ins) {
+    if (!jumpTargetOf(ins)) return false;
+    auto &opcode = std::get<std::string>(std::get<GenericReadInstruction>(ins).instruction[0]);
+    return (opcode == "jmpne" || opcode == "jmpl" || opcode == "jmpg") && comparesIdenticalImmediates(ins);
+}
+
+ControlFlowGraph generateCFG(const IR &ir) {
+    ControlFlowGraph cfg;
+    auto &instructions = ir.instructions;
+    cfg.blockOf.resize(instructions.size());
+
+    // a label starts a block, a jump ends one
+    std::map<std::string, std::size_t> labelToBlock;
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < instructions.size(); i++) {
+        if (labelOf(instructions[i]) && i != begin) {
+            cfg.blocks.emplace_back(begin, i);
+            begin = i;
+        }
+        if (auto label = labelOf(instructions[i])) {
+            labelToBlock.emplace(*label, cfg.blocks.size());
+        }
+        cfg.blockOf[i] = cfg.blocks.size();
+        if (jumpTargetOf(instructions[i])) {
+            cfg.blocks.emplace_back(begin, i + 1);
+            begin = i + 1;
+        }
+    }
+    if (begin != instructions.size() || cfg.blocks.empty()) {
+        cfg.blocks.emplace_back(begin, instructions.size());
+    }
+
+    auto addEdge = [&](std::size_t from, std::size_t to) {
+        for (auto e: cfg.blocks[from].successors) {
+            if (e == to) return;
+        }
+        cfg.blocks[from].successors.push_back(to);
+        cfg.blocks[to].predecessors.push_back(from);
+    };
+    for (std::size_t b = 0; b < cfg.blocks.size(); b++) {
+        auto &block = cfg.blocks[b];
+        if (block.begin == block.end) {
+            if (b + 1 < cfg.blocks.size()) addEdge(b, b + 1);
+            continue;
+        }
+        auto &last = instructions[block.end - 1];
+        if (!isUnconditionalJump(last) && b + 1 < cfg.blocks.size()) {
+            addEdge(b, b + 1);
+        }
+        if (auto target = jumpTargetOf(last); target && !isNeverTakenJump(last)) {
+            addEdge(b, labelToBlock.at(*target));
+        }
+    }
+    return cfg;
+}
+
+void removeRedundantControl(IR &ir) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::set<std::string> targets;
+        for (auto &ins: ir.instructions) {
+            if (auto target = jumpTargetOf(ins)) targets.insert(*target);
+        }
+        Instructions instructions;
+        for (std::size_t i = 0; i < ir.instructions.size(); i++) {
+            auto &ins = ir.instructions[i];
+            auto label = labelOf(ins);
+            auto target = jumpTargetOf(ins);
+            bool isDeadLabel = label && !targets.count(*label);
+            bool jumpsToNext = target && i + 1 < ir.instructions.size() && labelOf(ir.instructions[i + 1]) == target;
+            if (isDeadLabel || jumpsToNext) {
+                changed = true;
+                continue;
+            }
+            instructions.push_back(std::move(ins));
+        }
+        ir.instructions = std::move(instructions);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef CFG_HH
+#define CFG_HH
+#include <std20c/ir.hh>
+#include <optional>
+#include <string>
+#include <vector>
+
+// maximal run of instructions [begin, end) that is only entered at the top and only left at the bottom
+struct BasicBlock {
+    std::size_t begin;
+    std::size_t end;
+    std::vector<std::size_t> successors;    // fallthrough first, then jump target
+    std::vector<std::size_t> predecessors;
+    BasicBlock(std::size_t begin, std::size_t end): begin(begin), end(end) {}
+};
+
+struct ControlFlowGraph {
+    std::vector<BasicBlock> blocks;     // blocks[0] is the entry, blocks are in program order
+    std::vector<std::size_t> blockOf;   // maps instruction index to the block containing it
+};
+ControlFlowGraph generateCFG(const IR &);
+
+// name of the label declared by a `label` instruction
+std::optional<std::string> labelOf(const Instruction &);
+// label a `jmp*` instruction may transfer control to
+std::optional<std::string> jumpTargetOf(const Instruction &);
+// jumps comparing two identical immediates (e.g. `jmpe L 0 0`) always/never transfer control
+bool isUnconditionalJump(const Instruction &);
+bool isNeverTakenJump(const Instruction &);
+
+// drops jumps to the very next instruction (they do nothing) and labels no jump refers to (they only split blocks)
+void removeRedundantControl(IR &);
+
+#endif
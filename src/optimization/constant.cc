@@ -0,0 +1,59 @@
+#include "constant.hh"
+#include <charconv>
+#include <cmath>
+
+std::optional<double> parseNumber(const std::string &s) {
+    double value;
+    auto begin = s.data();
+    auto end = s.data() + s.size();
+    // from_chars does not take a leading '+', and neither does the std20c lexer
+    if (begin == end || *begin == '+') return std::nullopt;
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc() || ptr != end || !std::isfinite(value)) return std::nullopt;
+    return value;
+}
+
+std::string formatNumber(double value) {
+    if (value == 0) return "0";     // also drops the sign of -0
+    char buffer[400];
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+    return std::string(buffer, ptr);
+}
+
+Constant constantOfImmediate(const std::string &text) {
+    if (auto number = parseNumber(text)) return *number;
+    return text;
+}
+
+std::optional<std::string> immediateOf(const Constant &value) {
+    if (std::holds_alternative<double>(value)) {
+        auto number = std::get<double>(value);
+        if (number == 0 && std::signbit(number)) return std::nullopt;
+        return formatNumber(number);
+    }
+    if (std::holds_alternative<std::string>(value)) {
+        auto &text = std::get<std::string>(value);
+        if (parseNumber(text) || text.find('\n') != std::string::npos || (!text.empty() && text[0] == '$')) return std::nullopt;
+        return text;
+    }
+    return std::nullopt;
+}
+
+std::map<VReg, double> numericConstants(const IR &ir) {
+    std::map<VReg, size_t> defs;
+    std::map<VReg, double> constants;
+    for (auto &ins: ir.instructions) {
+        if (auto reg = writtenRegister(ins)) {
+            defs[*reg]++;
+            if (std::holds_alternative<ImmediateAssignInstruction>(ins)) {
+                if (auto value = parseNumber(std::get<ImmediateAssignInstruction>(ins).value)) {
+                    constants[*reg] = *value;
+                }
+            }
+        }
+    }
+    for (auto it = constants.begin(); it != constants.end();) {
+        it = defs[it->first] == 1 ? std::next(it) : constants.erase(it);
+    }
+    return constants;
+}
@@ -0,0 +1,28 @@
+#ifndef CONSTANT_HH
+#define CONSTANT_HH
+#include <std20c/ir.hh>
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <variant>
+
+// a std20 value known at compile time (entities never are)
+using ConstantVector = std::array<double, 3>;
+using Constant = std::variant<double, std::string, ConstantVector>;
+
+// parses an immediate operand as a finite std20 number
+std::optional<double> parseNumber(const std::string &);
+// shortest plain decimal text (no exponent) that parses back to the same number
+std::string formatNumber(double);
+
+// value written by `mov <text>`: std20 reads any immediate that looks like a number as one
+Constant constantOfImmediate(const std::string &);
+// text of an immediate std20 reads back as exactly this value, if there is one
+//  (never for vectors, -0 or strings that would be read as numbers or registers)
+std::optional<std::string> immediateOf(const Constant &);
+
+// value of every register whose only assignment in the program is a numeric immediate
+std::map<VReg, double> numericConstants(const IR &);
+
+#endif
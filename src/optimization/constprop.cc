@@ -0,0 +1,190 @@
+#include "constprop.hh"
+#include "effects.hh"
+#include "evaluate.hh"
+#include "liveness.hh"
+#include <cmath>
+#include <set>
+
+std::optional<Constant> valueOf(const std::variant<VReg, std::string> &operand, const ConstantState &state) {
+    if (std::holds_alternative<std::string>(operand)) return constantOfImmediate(std::get<std::string>(operand));
+    auto it = state.find(std::get<VReg>(operand));
+    return it == state.end() ? std::nullopt : std::make_optional(it->second);
+}
+
+// keeps only what both states agree on; returns whether `into` changed
+bool meet(ConstantState &into, const ConstantState &other) {
+    bool changed = false;
+    for (auto it = into.begin(); it != into.end();) {
+        auto match = other.find(it->first);
+        // 0 and -0 compare equal but are different values
+        bool differs = match == other.end() || match->second != it->second
+            || (std::holds_alternative<double>(it->second) && std::signbit(std::get<double>(it->second)) != std::signbit(std::get<double>(match->second)));
+        if (differs) {
+            it = into.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    return changed;
+}
+
+// operands known to be numbers are written as immediates, so the registers holding them need not be read
+void substituteNumbers(OperandList &operands, const ConstantState &state) {
+    for (auto &operand: operands) {
+        if (!std::holds_alternative<VReg>(operand)) continue;
+        auto value = valueOf(operand, state);
+        if (!value || !std::holds_alternative<double>(*value)) continue;
+        if (auto immediate = immediateOf(*value)) operand = *immediate;
+    }
+}
+
+// the value a write computes from operands known in `state`, if the host can evaluate it
+std::optional<Constant> valueOf(const GenericWriteInstruction &write, const ConstantState &state) {
+    std::vector<Constant> operands;
+    for (size_t i = 1; i < write.rhs.size(); i++) {
+        auto value = valueOf(write.rhs[i], state);
+        if (!value) return std::nullopt;
+        operands.push_back(*value);
+    }
+    return evaluateBuiltin(std::get<std::string>(write.rhs[0]), operands);
+}
+
+void transferConstants(const Instruction &ins, ConstantState &state) {
+    if (std::holds_alternative<ImmediateAssignInstruction>(ins)) {
+        auto &assign = std::get<ImmediateAssignInstruction>(ins);
+        state[assign.lhs] = constantOfImmediate(assign.value);
+    } else if (std::holds_alternative<RegisterAssignInstruction>(ins)) {
+        auto &assign = std::get<RegisterAssignInstruction>(ins);
+        auto value = valueOf(assign.rhs, state);
+        if (value) state[assign.lhs] = *value;
+        else state.erase(assign.lhs);
+    } else if (std::holds_alternative<GenericWriteInstruction>(ins)) {
+        auto &write = std::get<GenericWriteInstruction>(ins);
+        auto result = valueOf(write, state);
+        if (result) state[write.lhs] = *result;
+        else state.erase(write.lhs);
+    }
+}
+
+std::optional<bool> evaluateJump(const Instruction &ins, const ConstantState &state) {
+    if (!jumpTargetOf(ins)) return std::nullopt;
+    if (isUnconditionalJump(ins)) return true;
+    if (isNeverTakenJump(ins)) return false;
+    auto &list = std::get<GenericReadInstruction>(ins).instruction;
+    if (list.size() != 4) return std::nullopt;
+    auto left = valueOf(list[2], state);
+    auto right = valueOf(list[3], state);
+    if (!left || !right) return std::nullopt;
+    return compareConstants(std::get<std::string>(list[0]), *left, *right);
+}
+
+std::optional<Instruction> materializeConstant(VReg lhs, const Constant &value) {
+    if (auto immediate = immediateOf(value)) return ImmediateAssignInstruction(lhs, *immediate);
+    if (!std::holds_alternative<ConstantVector>(value)) return std::nullopt;
+    std::vector<std::variant<VReg, std::string>> makevec{"makevec"};
+    for (auto component: std::get<ConstantVector>(value)) {
+        auto immediate = immediateOf(component);
+        if (!immediate) return std::nullopt;
+        makevec.push_back(*immediate);
+    }
+    return GenericWriteInstruction(lhs, makevec);
+}
+
+std::vector<std::optional<ConstantState>> generateConstantStates(const IR &ir, const ControlFlowGraph &cfg) {
+    auto n = cfg.blocks.size();
+    std::map<std::string, size_t> labelToBlock;
+    for (size_t b = 0; b < n; b++) {
+        auto &block = cfg.blocks[b];
+        if (block.begin == block.end) continue;
+        if (auto label = labelOf(ir.instructions[block.begin])) labelToBlock.emplace(*label, b);
+    }
+
+    // the first waiting block runs next: lowering lays out both sides of a branch before their join and a
+    //  loop's body before the code after it, so a loop settles before what follows it runs (taking the
+    //  last one first ran all the code after a join or loop header again each time its state changed)
+    // a block's state holds only the registers live into it: the others are written before they are
+    //  read again, and with them every state grew with the length of the program
+    auto liveness = generateLiveness(ir, cfg);
+    std::vector<std::optional<ConstantState>> in(n);
+    in[0] = ConstantState();
+    std::set<size_t> worklist{0};
+    auto flowInto = [&](size_t b, const ConstantState &state) {
+        if (b >= n) return;
+        ConstantState live;
+        for (auto reg: liveness.liveIn[b]) {
+            auto value = state.find(reg);
+            if (value != state.end()) live.emplace_hint(live.end(), *value);
+        }
+        if (!in[b]) in[b] = std::move(live);
+        else if (!meet(*in[b], live)) return;
+        worklist.insert(b);
+    };
+    while (!worklist.empty()) {
+        auto b = *worklist.begin();
+        worklist.erase(worklist.begin());
+        auto &block = cfg.blocks[b];
+        auto state = *in[b];
+        for (auto i = block.begin; i < block.end; i++) {
+            transferConstants(ir.instructions[i], state);
+        }
+        if (block.begin == block.end || !jumpTargetOf(ir.instructions[block.end - 1])) {
+            flowInto(b + 1, state);
+            continue;
+        }
+        auto &last = ir.instructions[block.end - 1];
+        auto taken = evaluateJump(last, state);
+        if (taken != false) flowInto(labelToBlock.at(*jumpTargetOf(last)), state);
+        if (taken != true) flowInto(b + 1, state);
+    }
+    return in;
+}
+
+IR propagateConstants(const IR &old) {
+    auto cfg = generateCFG(old);
+    auto states = generateConstantStates(old, cfg);
+
+    IR ir;
+    ir.virtualRegisters = old.virtualRegisters;
+    for (size_t b = 0; b < cfg.blocks.size(); b++) {
+        if (!states[b]) continue;
+        auto state = *states[b];
+        for (auto i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            auto ins = old.instructions[i];
+            if (auto target = jumpTargetOf(ins)) {
+                auto taken = evaluateJump(ins, state);
+                if (taken == false) continue;
+                if (taken == true && !isUnconditionalJump(ins)) ins = GenericReadInstruction({"jmpe", *target, "0", "0"});
+                else substituteNumbers(std::get<GenericReadInstruction>(ins).instruction, state);
+            } else if (std::holds_alternative<RegisterAssignInstruction>(ins)) {
+                // a vector is copied with a `mov` more cheaply than rebuilt with `makevec`
+                auto &assign = std::get<RegisterAssignInstruction>(ins);
+                auto value = valueOf(assign.rhs, state);
+                auto immediate = value ? immediateOf(*value) : std::nullopt;
+                if (immediate) ins = ImmediateAssignInstruction(assign.lhs, *immediate);
+            } else if (std::holds_alternative<GenericWriteInstruction>(ins)) {
+                auto &write = std::get<GenericWriteInstruction>(ins);
+                auto folded = valueOf(write, state);
+                auto materialized = folded ? materializeConstant(write.lhs, *folded) : std::nullopt;
+                if (materialized) ins = *materialized;
+                else substituteNumbers(write.rhs, state);
+            } else if (std::holds_alternative<GenericReadInstruction>(ins) && !labelOf(ins)) {
+                auto &list = std::get<GenericReadInstruction>(ins).instruction;
+                substituteNumbers(list, state);
+                // std20 prints a number as its sify text, so text that is exactly that (like the result of
+                //  sify(1), "1.0") prints the same as the number it reads as
+                auto value = opcodeOf(ins) == "print" && list.size() == 2 ? valueOf(list[1], state) : std::nullopt;
+                if (value && std::holds_alternative<std::string>(*value)) {
+                    auto &text = std::get<std::string>(*value);
+                    auto number = parseNumber(text);
+                    if (number && sifyNumber(*number) == text) list[1] = text;
+                }
+            }
+            transferConstants(old.instructions[i], state);
+            ir.instructions.push_back(std::move(ins));
+        }
+    }
+
+    removeRedundantControl(ir);
+    return ir;
+}
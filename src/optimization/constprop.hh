@@ -0,0 +1,28 @@
+#ifndef CONSTPROP_HH
+#define CONSTPROP_HH
+#include "cfg.hh"
+#include "constant.hh"
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+// registers known to hold one value at a program point; registers not in the map may hold anything
+using ConstantState = std::map<VReg, Constant>;
+
+// state on entry to every block, following only jumps that can be taken (nullopt: the block never runs)
+std::vector<std::optional<ConstantState>> generateConstantStates(const IR &, const ControlFlowGraph &);
+// updates the state past one instruction
+void transferConstants(const Instruction &, ConstantState &);
+// whether a jump is taken in the given state (nullopt if its operands are not known)
+std::optional<bool> evaluateJump(const Instruction &, const ConstantState &);
+
+// an instruction setting `lhs` to the value: an immediate move, or `makevec` of immediates for vectors
+std::optional<Instruction> materializeConstant(VReg lhs, const Constant &);
+
+// conditional constant propagation: replaces computations on known values (arithmetic and the
+//  pure builtins the host can evaluate exactly, see evaluate.hh) with their result,
+//  folds jumps whose outcome is known and drops the code that can no longer run
+IR propagateConstants(const IR &ir);
+
+#endif
@@ -0,0 +1,54 @@
+#include "dce.hh"
+#include "cfg.hh"
+#include "effects.hh"
+#include "liveness.hh"
+#include "loops.hh"
+
+bool isRemovableWhenUnused(const Instruction &ins) {
+    auto effect = instructionEffect(ins);
+    return (effect == PURE_EFFECT || effect == WORLD_READ_EFFECT) && !mayTrap(ins);
+}
+
+IR eliminateDeadCode(const IR &old) {
+    IR ir = old;
+    // removing a write can make the writes feeding it dead too, also across blocks
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        auto cfg = generateCFG(ir);
+        auto liveness = generateLiveness(ir, cfg);
+        std::vector<bool> reachable(cfg.blocks.size());
+        for (auto block: reversePostorder(cfg)) {
+            reachable[block] = true;
+        }
+
+        std::vector<bool> removed(ir.instructions.size());
+        for (size_t b = 0; b < cfg.blocks.size(); b++) {
+            auto &block = cfg.blocks[b];
+            if (!reachable[b]) {
+                for (auto i = block.begin; i < block.end; i++) removed[i] = true;
+                continue;
+            }
+            auto live = liveness.liveOut[b];
+            for (auto i = block.end; i-- > block.begin;) {
+                auto &ins = ir.instructions[i];
+                auto lhs = writtenRegister(ins);
+                if (lhs && !live.count(*lhs) && isRemovableWhenUnused(ins)) {
+                    removed[i] = true;
+                    continue;
+                }
+                if (lhs) live.erase(*lhs);
+                for (auto reg: readRegisters(ins)) live.insert(reg);
+            }
+        }
+
+        Instructions instructions;
+        for (size_t i = 0; i < ir.instructions.size(); i++) {
+            if (removed[i]) changed = true;
+            else instructions.push_back(std::move(ir.instructions[i]));
+        }
+        ir.instructions = std::move(instructions);
+    }
+    removeRedundantControl(ir);
+    return ir;
+}
@@ -0,0 +1,10 @@
+#ifndef DCE_HH
+#define DCE_HH
+#include <std20c/ir.hh>
+
+// dead-code elimination: drops blocks no path from the entry reaches, and writes of values no path
+//  reads again when the instruction has no other effect (pure or world-reading builtins that cannot
+//  trap); calls that change the world, print or wait always stay even if their result is unused
+IR eliminateDeadCode(const IR &ir);
+
+#endif
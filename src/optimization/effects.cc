@@ -0,0 +1,80 @@
+#include "effects.hh"
+#include <map>
+
+// world queries only read state, but one that finds nothing (no entity near, one that is gone) fails and
+//  aborts the spell, see World in vm/world.hh, so they trap as well
+const std::map<std::string, EffectClass> builtinEffects {
+    {"mov", PURE_EFFECT},
+    {"add", PURE_EFFECT},
+    {"sub", PURE_EFFECT},
+    {"mul", PURE_EFFECT},
+    {"div", PURE_EFFECT},
+    {"round", PURE_EFFECT},
+    {"sqrt", PURE_EFFECT},
+    {"sin", PURE_EFFECT},
+    {"cos", PURE_EFFECT},
+    {"makevec", PURE_EFFECT},
+    {"vx", PURE_EFFECT},
+    {"vy", PURE_EFFECT},
+    {"vz", PURE_EFFECT},
+    {"vadd", PURE_EFFECT},
+    {"vsub", PURE_EFFECT},
+    {"vmul", PURE_EFFECT},
+    {"vdiv", PURE_EFFECT},
+    {"vdist", PURE_EFFECT},
+    {"vnorm", PURE_EFFECT},
+    {"vdot", PURE_EFFECT},
+    {"vcross", PURE_EFFECT},
+    {"slength", PURE_EFFECT},
+    {"scharat", PURE_EFFECT},
+    {"scodeat", PURE_EFFECT},
+    {"ssubstr", PURE_EFFECT},
+    {"sconcat", PURE_EFFECT},
+    {"ssearch", PURE_EFFECT},
+    {"scmp", PURE_EFFECT},
+    {"sify", PURE_EFFECT},
+    {"sifyd", PURE_EFFECT},
+    {"findent", WORLD_READ_EFFECT},
+    {"entpos", WORLD_READ_EFFECT},
+    {"entvel", WORLD_READ_EFFECT},
+    {"entfacing", WORLD_READ_EFFECT},
+    {"checkblock", WORLD_READ_EFFECT},
+    {"print", OUTPUT_EFFECT},
+    {"accelent", WORLD_WRITE_EFFECT},
+    {"damageent", WORLD_WRITE_EFFECT},
+    {"mountent", WORLD_WRITE_EFFECT},
+    {"fireballpwr", WORLD_WRITE_EFFECT},
+    {"explode", WORLD_WRITE_EFFECT},
+    {"placeblock", WORLD_WRITE_EFFECT},
+    {"destroyblock", WORLD_WRITE_EFFECT},
+    {"lightning", WORLD_WRITE_EFFECT},
+    {"summon", WORLD_WRITE_EFFECT},
+    {"wait", SUSPEND_EFFECT},
+};
+
+std::string opcodeOf(const Instruction &ins) {
+    if (std::holds_alternative<GenericWriteInstruction>(ins)) {
+        return std::get<std::string>(std::get<GenericWriteInstruction>(ins).rhs.at(0));
+    } else if (std::holds_alternative<GenericReadInstruction>(ins)) {
+        return std::get<std::string>(std::get<GenericReadInstruction>(ins).instruction.at(0));
+    } else {
+        return "mov";
+    }
+}
+
+EffectClass opcodeEffect(const std::string &opcode) {
+    if (opcode == "label" || opcode.rfind("jmp", 0) == 0) return CONTROL_EFFECT;
+    auto it = builtinEffects.find(opcode);
+    // unknown operations are assumed to do anything
+    return it == builtinEffects.end() ? SUSPEND_EFFECT : it->second;
+}
+
+EffectClass instructionEffect(const Instruction &ins) {
+    return opcodeEffect(opcodeOf(ins));
+}
+
+bool mayTrap(const Instruction &ins) {
+    auto opcode = opcodeOf(ins);
+    return opcode == "scharat" || opcode == "scodeat" || opcode == "ssubstr"
+        || opcodeEffect(opcode) >= WORLD_READ_EFFECT;
+}
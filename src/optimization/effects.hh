@@ -0,0 +1,27 @@
+#ifndef EFFECTS_HH
+#define EFFECTS_HH
+#include <std20c/ir.hh>
+#include <string>
+
+// how an instruction interacts with the std20 world, from least to most restrictive
+enum EffectClass {
+    PURE_EFFECT,            // result depends only on the operands
+    WORLD_READ_EFFECT,      // observes entities/blocks but does not change them
+    OUTPUT_EFFECT,          // prints; must stay in order but leaves the world unchanged
+    WORLD_WRITE_EFFECT,     // changes the world
+    SUSPEND_EFFECT,         // yields to the game (wait); the world may change arbitrarily
+    CONTROL_EFFECT          // labels and jumps
+};
+
+// name of the std20 operation an instruction performs ("mov" for both assign instructions)
+std::string opcodeOf(const Instruction &);
+
+EffectClass opcodeEffect(const std::string &opcode);
+EffectClass instructionEffect(const Instruction &);
+
+// true if the instruction can abort the spell at runtime (e.g. out of range string index, a world query
+//  that finds nothing)
+//  such instructions must not be executed speculatively
+bool mayTrap(const Instruction &);
+
+#endif
@@ -0,0 +1,283 @@
+#include "evaluate.hh"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <map>
+
+using Operands = std::vector<Constant>;
+
+std::optional<double> numberOf(const Constant &value) {
+    if (!std::holds_alternative<double>(value)) return std::nullopt;
+    return std::get<double>(value);
+}
+std::optional<std::string> stringOf(const Constant &value) {
+    if (!std::holds_alternative<std::string>(value)) return std::nullopt;
+    return std::get<std::string>(value);
+}
+std::optional<ConstantVector> vectorOf(const Constant &value) {
+    if (!std::holds_alternative<ConstantVector>(value)) return std::nullopt;
+    return std::get<ConstantVector>(value);
+}
+
+// std20 indexes strings with Java's int conversion of a number; only whole numbers in range are folded
+std::optional<size_t> indexOf(const Constant &value, size_t limit) {
+    auto number = numberOf(value);
+    if (!number || *number < 0 || *number > limit || *number != std::floor(*number)) return std::nullopt;
+    return static_cast<size_t>(*number);
+}
+
+// Java strings count UTF-16 units; the lexer only produces ASCII, but keep other text unfolded
+bool isAscii(const std::string &text) {
+    for (unsigned char c: text) {
+        if (c >= 0x80) return false;
+    }
+    return true;
+}
+
+// arithmetic follows Java's double operations; vector operations follow Minecraft's Vec3d
+const std::map<std::string, std::function<std::optional<Constant>(const Operands &)>> builtins {
+    {"add", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]), b = numberOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return *a + *b;
+    }},
+    {"sub", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]), b = numberOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return *a - *b;
+    }},
+    {"mul", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]), b = numberOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return *a * *b;
+    }},
+    {"div", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]), b = numberOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return *a / *b;
+    }},
+    {"sqrt", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]);
+        if (!a) return std::nullopt;
+        return std::sqrt(*a);
+    }},
+    {"sin", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]);
+        if (!a) return std::nullopt;
+        return std::sin(*a);
+    }},
+    {"cos", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]);
+        if (!a) return std::nullopt;
+        return std::cos(*a);
+    }},
+    // Math.round: floor(x + 1/2) taken exactly, so 0.49999999999999994 rounds to 0, into a long
+    {"round", [](const Operands &o) -> std::optional<Constant> {
+        auto a = numberOf(o[0]);
+        if (!a) return std::nullopt;
+        if (std::isnan(*a)) return 0.0;
+        if (std::fabs(*a) >= 0x1p52) return std::clamp(*a, -0x1p63, 0x1p63);
+        auto floor = std::floor(*a);
+        return *a - floor >= 0.5 ? floor + 1 : floor;
+    }},
+    {"makevec", [](const Operands &o) -> std::optional<Constant> {
+        auto x = numberOf(o[0]), y = numberOf(o[1]), z = numberOf(o[2]);
+        if (!x || !y || !z) return std::nullopt;
+        return ConstantVector{*x, *y, *z};
+    }},
+    {"vx", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        if (!v) return std::nullopt;
+        return (*v)[0];
+    }},
+    {"vy", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        if (!v) return std::nullopt;
+        return (*v)[1];
+    }},
+    {"vz", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        if (!v) return std::nullopt;
+        return (*v)[2];
+    }},
+    {"vadd", [](const Operands &o) -> std::optional<Constant> {
+        auto a = vectorOf(o[0]), b = vectorOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return ConstantVector{(*a)[0] + (*b)[0], (*a)[1] + (*b)[1], (*a)[2] + (*b)[2]};
+    }},
+    {"vsub", [](const Operands &o) -> std::optional<Constant> {
+        auto a = vectorOf(o[0]), b = vectorOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return ConstantVector{(*a)[0] - (*b)[0], (*a)[1] - (*b)[1], (*a)[2] - (*b)[2]};
+    }},
+    {"vmul", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        auto s = numberOf(o[1]);
+        if (!v || !s) return std::nullopt;
+        return ConstantVector{(*v)[0] * *s, (*v)[1] * *s, (*v)[2] * *s};
+    }},
+    {"vdiv", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        auto s = numberOf(o[1]);
+        if (!v || !s) return std::nullopt;
+        return ConstantVector{(*v)[0] / *s, (*v)[1] / *s, (*v)[2] / *s};
+    }},
+    {"vdist", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        if (!v) return std::nullopt;
+        return std::sqrt((*v)[0] * (*v)[0] + (*v)[1] * (*v)[1] + (*v)[2] * (*v)[2]);
+    }},
+    // Vec3d.normalize returns the zero vector below a length of 1e-4
+    {"vnorm", [](const Operands &o) -> std::optional<Constant> {
+        auto v = vectorOf(o[0]);
+        if (!v) return std::nullopt;
+        auto length = std::sqrt((*v)[0] * (*v)[0] + (*v)[1] * (*v)[1] + (*v)[2] * (*v)[2]);
+        if (length < 1e-4) return ConstantVector{0, 0, 0};
+        return ConstantVector{(*v)[0] / length, (*v)[1] / length, (*v)[2] / length};
+    }},
+    {"vdot", [](const Operands &o) -> std::optional<Constant> {
+        auto a = vectorOf(o[0]), b = vectorOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return (*a)[0] * (*b)[0] + (*a)[1] * (*b)[1] + (*a)[2] * (*b)[2];
+    }},
+    {"vcross", [](const Operands &o) -> std::optional<Constant> {
+        auto a = vectorOf(o[0]), b = vectorOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return ConstantVector{(*a)[1] * (*b)[2] - (*a)[2] * (*b)[1],
+                            (*a)[2] * (*b)[0] - (*a)[0] * (*b)[2],
+                            (*a)[0] * (*b)[1] - (*a)[1] * (*b)[0]};
+    }},
+    {"slength", [](const Operands &o) -> std::optional<Constant> {
+        auto s = stringOf(o[0]);
+        if (!s || !isAscii(*s)) return std::nullopt;
+        return static_cast<double>(s->size());
+    }},
+    {"sconcat", [](const Operands &o) -> std::optional<Constant> {
+        auto a = stringOf(o[0]), b = stringOf(o[1]);
+        if (!a || !b) return std::nullopt;
+        return *a + *b;
+    }},
+    {"ssubstr", [](const Operands &o) -> std::optional<Constant> {
+        auto s = stringOf(o[0]);
+        if (!s || !isAscii(*s)) return std::nullopt;
+        auto begin = indexOf(o[1], s->size()), end = indexOf(o[2], s->size());
+        if (!begin || !end || *begin > *end) return std::nullopt;
+        return s->substr(*begin, *end - *begin);
+    }},
+    {"scharat", [](const Operands &o) -> std::optional<Constant> {
+        auto s = stringOf(o[0]);
+        if (!s || !isAscii(*s) || s->empty()) return std::nullopt;
+        auto index = indexOf(o[1], s->size() - 1);
+        if (!index) return std::nullopt;
+        return s->substr(*index, 1);
+    }},
+    {"scodeat", [](const Operands &o) -> std::optional<Constant> {
+        auto s = stringOf(o[0]);
+        if (!s || !isAscii(*s) || s->empty()) return std::nullopt;
+        auto index = indexOf(o[1], s->size() - 1);
+        if (!index) return std::nullopt;
+        return static_cast<double>((*s)[*index]);
+    }},
+    {"ssearch", [](const Operands &o) -> std::optional<Constant> {
+        auto s = stringOf(o[0]), t = stringOf(o[1]);
+        if (!s || !t || !isAscii(*s) || !isAscii(*t)) return std::nullopt;
+        auto found = s->find(*t);
+        return found == std::string::npos ? -1.0 : static_cast<double>(found);
+    }},
+    // String.compareTo: the difference of the first differing characters, else of the lengths
+    {"scmp", [](const Operands &o) -> std::optional<Constant> {
+        auto s = stringOf(o[0]), t = stringOf(o[1]);
+        if (!s || !t || !isAscii(*s) || !isAscii(*t)) return std::nullopt;
+        for (size_t i = 0; i < s->size() && i < t->size(); i++) {
+            if ((*s)[i] != (*t)[i]) return static_cast<double>((*s)[i] - (*t)[i]);
+        }
+        return static_cast<double>(s->size()) - static_cast<double>(t->size());
+    }},
+    // Vec3d.toString for vectors
+    {"sify", [](const Operands &o) -> std::optional<Constant> {
+        if (auto s = stringOf(o[0])) return *s;
+        if (auto n = numberOf(o[0])) return sifyNumber(*n);
+        auto v = vectorOf(o[0]);
+        return "(" + sifyNumber((*v)[0]) + ", " + sifyNumber((*v)[1]) + ", " + sifyNumber((*v)[2]) + ")";
+    }},
+};
+
+// operand count of every builtin above
+const std::map<std::string, size_t> arities {
+    {"add", 2}, {"sub", 2}, {"mul", 2}, {"div", 2}, {"sqrt", 1}, {"sin", 1}, {"cos", 1}, {"round", 1},
+    {"makevec", 3}, {"vx", 1}, {"vy", 1}, {"vz", 1}, {"vadd", 2}, {"vsub", 2}, {"vmul", 2}, {"vdiv", 2},
+    {"vdist", 1}, {"vnorm", 1}, {"vdot", 2}, {"vcross", 2}, {"slength", 1}, {"sconcat", 2},
+    {"ssubstr", 3}, {"scharat", 2}, {"scodeat", 2}, {"ssearch", 2}, {"scmp", 2}, {"sify", 1},
+};
+
+std::optional<Constant> applyBuiltin(const std::string &opcode, const std::vector<Constant> &operands) {
+    auto builtin = builtins.find(opcode);
+    if (builtin == builtins.end() || arities.at(opcode) != operands.size()) return std::nullopt;
+    return builtin->second(operands);
+}
+
+std::optional<Constant> evaluateBuiltin(const std::string &opcode, const std::vector<Constant> &operands) {
+    auto result = applyBuiltin(opcode, operands);
+    if (!result) return std::nullopt;
+    // NaN and the infinities have no immediate to be written as
+    if (auto n = numberOf(*result); n && !std::isfinite(*n)) return std::nullopt;
+    if (auto v = vectorOf(*result)) {
+        for (auto component: *v) {
+            if (!std::isfinite(component)) return std::nullopt;
+        }
+    }
+    return result;
+}
+
+std::optional<bool> compareConstants(const std::string &opcode, const Constant &left, const Constant &right) {
+    auto l = numberOf(left), r = numberOf(right);
+    // numbers compare as Java doubles, so every comparison with NaN but `jmpne` fails
+    if (l && r) {
+        if (opcode == "jmpe") return *l == *r;
+        if (opcode == "jmpne") return *l != *r;
+        if (opcode == "jmpl") return *l < *r;
+        if (opcode == "jmple") return *l <= *r;
+        if (opcode == "jmpg") return *l > *r;
+        if (opcode == "jmpge") return *l >= *r;
+        return std::nullopt;
+    }
+    // other values only compare for equality, with values of their own kind
+    if (left.index() != right.index()) return std::nullopt;
+    if (left != right) {
+        if (opcode == "jmpne") return true;
+        if (opcode == "jmpe") return false;
+        return std::nullopt;
+    }
+    if (opcode == "jmpe" || opcode == "jmple" || opcode == "jmpge") return true;
+    if (opcode == "jmpne" || opcode == "jmpl" || opcode == "jmpg") return false;
+    return std::nullopt;
+}
+
+std::string sifyNumber(double value) {
+    if (std::isnan(value)) return "NaN";
+    if (std::isinf(value)) return value < 0 ? "-Infinity" : "Infinity";
+    if (value == 0) return std::signbit(value) ? "-0.0" : "0.0";
+    // shortest round-trip digits, e.g. "-1.2345e+02"
+    char buffer[32];
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific);
+    std::string scientific(buffer, ptr);
+    auto e = scientific.find('e');
+    auto exponent = std::atoi(scientific.c_str() + e + 1);
+    std::string sign = value < 0 ? "-" : "";
+    std::string digits;
+    for (size_t i = sign.size(); i < e; i++) {
+        if (scientific[i] != '.') digits += scientific[i];
+    }
+
+    auto magnitude = std::fabs(value);
+    if (magnitude >= 1e-3 && magnitude < 1e7) {
+        if (exponent < 0) return sign + "0." + std::string(-exponent - 1, '0') + digits;
+        if (digits.size() <= static_cast<size_t>(exponent) + 1) digits += std::string(exponent + 1 - digits.size(), '0');
+        auto fraction = digits.substr(exponent + 1);
+        return sign + digits.substr(0, exponent + 1) + "." + (fraction.empty() ? "0" : fraction);
+    }
+    auto fraction = digits.substr(1);
+    return sign + digits[0] + "." + (fraction.empty() ? "0" : fraction) + "E" + std::to_string(exponent);
+}
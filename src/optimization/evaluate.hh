@@ -0,0 +1,21 @@
+#ifndef EVALUATE_HH
+#define EVALUATE_HH
+#include "constant.hh"
+#include <optional>
+#include <string>
+#include <vector>
+
+// std20's pure builtins as the game computes them: the result of `opcode` on known operands, including
+//  NaN and the infinities; nullopt where std20 would trap or behave in a way not modelled here
+std::optional<Constant> applyBuiltin(const std::string &opcode, const std::vector<Constant> &operands);
+// applyBuiltin for folding at compile time: also nullopt for non-finite results, which have no immediate
+std::optional<Constant> evaluateBuiltin(const std::string &opcode, const std::vector<Constant> &operands);
+
+// whether a `jmp*` comparing two known values is taken
+std::optional<bool> compareConstants(const std::string &opcode, const Constant &left, const Constant &right);
+
+// std20's text for a number (`sify`): Java's Double.toString, i.e. the shortest digits that read back
+//  as the same double, plain between 10^-3 and 10^7 and in computerized scientific notation otherwise
+std::string sifyNumber(double);
+
+#endif
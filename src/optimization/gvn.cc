@@ -0,0 +1,165 @@
+#include "gvn.hh"
+#include "cfg.hh"
+#include "effects.hh"
+#include "loops.hh"
+#include <map>
+#include <optional>
+#include <tuple>
+
+using Operand = std::variant<VReg, std::string>;
+// operation + operands, versions of the multiply-defined operands, world version for world queries
+using ExpressionKey = std::tuple<std::vector<Operand>, std::vector<size_t>, size_t>;
+
+struct NumberingState {
+    const IR &ir;
+    std::map<VReg, size_t> defsInProgram;
+    std::map<VReg, VReg> replacement;       // single-definition register => register with the same value
+    std::vector<bool> removed;
+
+    // scoped tables; undo logs are unwound when leaving a dominator subtree
+    std::map<ExpressionKey, VReg> available;
+    std::vector<std::pair<ExpressionKey, std::optional<VReg>>> availableLog;
+    std::map<VReg, size_t> varVersion;
+    std::vector<std::pair<VReg, std::optional<size_t>>> varVersionLog;
+
+    // any value recorded before a join or a world change has a smaller version than these
+    size_t generation{0};
+    size_t varEpoch{0};
+    size_t worldVersion{0};
+
+    VReg canonical(VReg reg) const {
+        auto it = replacement.find(reg);
+        return it == replacement.end() ? reg : it->second;
+    }
+    bool isSingleDef(VReg reg) { return defsInProgram[reg] == 1; }
+    size_t versionOf(VReg reg) const {
+        auto it = varVersion.find(reg);
+        return it != varVersion.end() && it->second > varEpoch ? it->second : varEpoch;
+    }
+    void redefine(VReg reg) {
+        auto it = varVersion.find(reg);
+        varVersionLog.emplace_back(reg, it == varVersion.end() ? std::nullopt : std::make_optional(it->second));
+        varVersion[reg] = ++generation;
+    }
+    void makeAvailable(const ExpressionKey &key, VReg reg) {
+        auto it = available.find(key);
+        availableLog.emplace_back(key, it == available.end() ? std::nullopt : std::make_optional(it->second));
+        available[key] = reg;
+    }
+    NumberingState(const IR &ir): ir(ir), removed(ir.instructions.size()) {}
+};
+
+template <typename Key, typename Value>
+void unwind(std::map<Key, Value> &table, std::vector<std::pair<Key, std::optional<Value>>> &log, size_t size) {
+    while (log.size() > size) {
+        auto &[key, old] = log.back();
+        if (old) table[key] = *old;
+        else table.erase(key);
+        log.pop_back();
+    }
+}
+
+void numberInstruction(NumberingState &state, size_t i) {
+    auto ins = state.ir.instructions[i];
+    visitVReg(ins, [&](VReg &r) { r = state.canonical(r); }, [](VReg &) {});
+    auto effect = instructionEffect(ins);
+    auto lhs = writtenRegister(ins);
+
+    if (lhs && state.isSingleDef(*lhs) && (effect == PURE_EFFECT || effect == WORLD_READ_EFFECT)) {
+        // copies of values that never change are forwarded directly
+        if (std::holds_alternative<RegisterAssignInstruction>(ins)) {
+            auto rhs = std::get<RegisterAssignInstruction>(ins).rhs;
+            if (state.isSingleDef(rhs)) {
+                state.replacement[*lhs] = rhs;
+                state.removed[i] = true;
+                return;
+            }
+        }
+        ExpressionKey key;
+        auto &[operands, versions, world] = key;
+        if (std::holds_alternative<ImmediateAssignInstruction>(ins)) {
+            operands = {"mov", std::get<ImmediateAssignInstruction>(ins).value};
+        } else if (std::holds_alternative<RegisterAssignInstruction>(ins)) {
+            operands = {"mov", std::get<RegisterAssignInstruction>(ins).rhs};
+        } else {
+            auto &rhs = std::get<GenericWriteInstruction>(ins).rhs;
+            operands.assign(rhs.begin(), rhs.end());
+        }
+        for (auto reg: readRegisters(ins)) {
+            if (!state.isSingleDef(reg)) versions.push_back(state.versionOf(reg));
+        }
+        world = effect == WORLD_READ_EFFECT ? state.worldVersion : 0;
+
+        auto it = state.available.find(key);
+        if (it != state.available.end()) {
+            state.replacement[*lhs] = it->second;
+            state.removed[i] = true;
+        } else {
+            state.makeAvailable(key, *lhs);
+        }
+        return;
+    }
+    if (lhs && !state.isSingleDef(*lhs)) {
+        state.redefine(*lhs);
+    }
+    if (effect == WORLD_WRITE_EFFECT || effect == SUSPEND_EFFECT) {
+        state.worldVersion = ++state.generation;
+    }
+}
+
+IR eliminateCommonSubexpressions(const IR &old) {
+    auto cfg = generateCFG(old);
+    auto idom = generateDominatorTree(cfg);
+    std::vector<std::vector<size_t>> children(cfg.blocks.size());
+    for (size_t b = 1; b < cfg.blocks.size(); b++) {
+        if (idom[b] != noDominator) children[idom[b]].push_back(b);
+    }
+
+    NumberingState state(old);
+    for (auto &ins: old.instructions) {
+        if (auto reg = writtenRegister(ins)) state.defsInProgram[*reg]++;
+    }
+
+    // iterative preorder walk of the dominator tree; a frame remembers the state to restore for its children
+    struct Frame {
+        size_t block;
+        size_t nextChild;
+        size_t varEpoch, worldVersion, availableSize, varVersionSize;
+    };
+    std::vector<Frame> stack;
+    auto enter = [&](size_t block) {
+        auto &preds = cfg.blocks[block].predecessors;
+        // anything may have happened on the other paths into a join
+        if (block == 0 || preds.size() != 1 || preds[0] != idom[block]) {
+            state.varEpoch = ++state.generation;
+            state.worldVersion = ++state.generation;
+        }
+        for (auto i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) {
+            numberInstruction(state, i);
+        }
+        stack.push_back({block, 0, state.varEpoch, state.worldVersion, state.availableLog.size(), state.varVersionLog.size()});
+    };
+    enter(0);
+    while (!stack.empty()) {
+        auto &frame = stack.back();
+        unwind(state.available, state.availableLog, frame.availableSize);
+        unwind(state.varVersion, state.varVersionLog, frame.varVersionSize);
+        state.varEpoch = frame.varEpoch;
+        state.worldVersion = frame.worldVersion;
+        if (frame.nextChild < children[frame.block].size()) {
+            enter(children[frame.block][frame.nextChild++]);
+        } else {
+            stack.pop_back();
+        }
+    }
+
+    IR ir;
+    ir.virtualRegisters = old.virtualRegisters;
+    for (size_t i = 0; i < old.instructions.size(); i++) {
+        if (state.removed[i]) continue;
+        auto ins = old.instructions[i];
+        visitVReg(ins, [&](VReg &r) { r = state.canonical(r); }, [](VReg &) {});
+        ir.instructions.push_back(std::move(ins));
+    }
+    return ir;
+}
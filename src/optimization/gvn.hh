@@ -0,0 +1,10 @@
+#ifndef GVN_HH
+#define GVN_HH
+#include <std20c/ir.hh>
+
+// dominator-based global value numbering: a computation that was already done on every path
+//  to an instruction is replaced by the register holding the earlier result
+//  world queries are only reused while no world write, wait or control flow join lies in between
+IR eliminateCommonSubexpressions(const IR &ir);
+
+#endif
@@ -0,0 +1,408 @@
+#include "induction.hh"
+#include "cfg.hh"
+#include "constant.hh"
+#include "liveness.hh"
+#include "loops.hh"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <optional>
+#include <set>
+
+// values that are multiples of 1/65536 below 2^15: products with the loop counter and running sums
+//  of them stay exactly representable, so reduced code computes the same values (see keepsSignOfZero
+//  for the sign of a zero)
+bool isExactStep(double value) {
+    double scaled = value * 65536;
+    return std::fabs(value) < 32768 && scaled == std::floor(scaled);
+}
+
+// facts about the whole program, gathered once per sweep and shared by the loops rewritten in it
+struct ProgramFacts {
+    std::map<VReg, double> constants;
+    std::map<VReg, size_t> defsInProgram;
+    std::map<VReg, size_t> definition;              // last (for single-def registers: only) write of a register
+    std::map<VReg, std::vector<size_t>> uses;
+    std::map<VReg, std::vector<size_t>> defs;       // every write of a register
+
+    explicit ProgramFacts(const IR &ir): constants(numericConstants(ir)) {
+        for (size_t i = 0; i < ir.instructions.size(); i++) {
+            for (auto reg: readRegisters(ir.instructions[i])) {
+                uses[reg].push_back(i);
+            }
+            if (auto reg = writtenRegister(ir.instructions[i])) {
+                defsInProgram[*reg]++;
+                definition[*reg] = i;
+                defs[*reg].push_back(i);
+            }
+        }
+    }
+};
+
+struct InductionAnalysis {
+    IR &ir;
+    const ControlFlowGraph &cfg;
+    const DominatorTree &idom;
+    const Loop &loop;
+    std::map<VReg, double> &constants;
+    std::map<VReg, size_t> &defsInProgram;
+    std::map<VReg, size_t> &definition;
+    std::map<VReg, std::vector<size_t>> &uses;
+    std::map<VReg, std::vector<size_t>> &defs;
+    std::map<VReg, std::vector<size_t>> defsInLoop;
+
+    bool inLoop(size_t i) const { return loop.contains(cfg.blockOf[i]); }
+    bool isSingleDef(VReg reg) { return defsInProgram[reg] == 1; }
+    // constant value of an operand, either an immediate or a register only ever assigned one
+    std::optional<double> constantOf(const std::variant<VReg, std::string> &operand) {
+        if (std::holds_alternative<std::string>(operand)) return parseNumber(std::get<std::string>(operand));
+        auto it = constants.find(std::get<VReg>(operand));
+        return it == constants.end() ? std::nullopt : std::make_optional(it->second);
+    }
+    // register `reg` copies in the loop, if it is a single-def `$reg = mov $source`
+    std::optional<VReg> copiedFrom(VReg reg) {
+        if (!isSingleDef(reg)) return std::nullopt;
+        auto &ins = ir.instructions[definition[reg]];
+        if (!std::holds_alternative<RegisterAssignInstruction>(ins)) return std::nullopt;
+        return std::get<RegisterAssignInstruction>(ins).rhs;
+    }
+
+    InductionAnalysis(IR &ir, const ControlFlowGraph &cfg, const DominatorTree &idom, ProgramFacts &facts, const Loop &loop):
+        ir(ir), cfg(cfg), idom(idom), loop(loop), constants(facts.constants), defsInProgram(facts.defsInProgram),
+        definition(facts.definition), uses(facts.uses), defs(facts.defs) {
+        for (auto block: loop.blocks) {
+            for (auto i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) {
+                if (auto reg = writtenRegister(ir.instructions[i])) defsInLoop[*reg].push_back(i);
+            }
+        }
+    }
+};
+
+// i = i + step once per iteration, starting from a constant
+//  lowered as `$u = mov $i; $t = add $u $c; $i = mov $t` within one block
+struct BasicInductionVariable {
+    VReg reg;
+    size_t update;      // `$i = mov $t`
+    size_t increment;   // `$t = add $u $c`
+    double initial;
+    double step;
+};
+
+std::optional<BasicInductionVariable> matchBasicInductionVariable(InductionAnalysis &a, VReg reg) {
+    if (a.defsInLoop[reg].size() != 1 || a.defsInProgram[reg] != 2) return std::nullopt;
+    auto update = a.defsInLoop[reg][0];
+    auto &updateIns = a.ir.instructions[update];
+    if (!std::holds_alternative<RegisterAssignInstruction>(updateIns)) return std::nullopt;
+
+    auto t = std::get<RegisterAssignInstruction>(updateIns).rhs;
+    if (!a.isSingleDef(t)) return std::nullopt;
+    auto increment = a.definition[t];
+    auto &incrementIns = a.ir.instructions[increment];
+    if (!std::holds_alternative<GenericWriteInstruction>(incrementIns)) return std::nullopt;
+    auto &rhs = std::get<GenericWriteInstruction>(incrementIns).rhs;
+    if (rhs.size() != 3) return std::nullopt;
+    auto &opcode = std::get<std::string>(rhs[0]);
+
+    // which operand is the old value of i, and what is added to it
+    auto isOldValue = [&](const std::variant<VReg, std::string> &operand) {
+        if (!std::holds_alternative<VReg>(operand)) return false;
+        auto u = std::get<VReg>(operand);
+        auto source = a.copiedFrom(u);
+        auto copy = a.definition[u];
+        return source == reg && a.cfg.blockOf[copy] == a.cfg.blockOf[update] && copy < increment && increment < update;
+    };
+    std::optional<double> step;
+    if (opcode == "add" && isOldValue(rhs[1])) step = a.constantOf(rhs[2]);
+    else if (opcode == "add" && isOldValue(rhs[2])) step = a.constantOf(rhs[1]);
+    else if (opcode == "sub" && isOldValue(rhs[1])) {
+        if (auto c = a.constantOf(rhs[2])) step = -*c;
+    }
+    if (!step || !isExactStep(*step)) return std::nullopt;
+
+    // the one definition outside the loop sets the initial value on every path into the loop
+    size_t init = 0;
+    for (auto i: a.defs[reg]) {
+        if (i != update) init = i;
+    }
+    if (!dominates(a.idom, a.cfg.blockOf[init], a.loop.header) || a.inLoop(init)) return std::nullopt;
+    std::optional<double> initial;
+    auto &initIns = a.ir.instructions[init];
+    if (std::holds_alternative<ImmediateAssignInstruction>(initIns)) {
+        initial = parseNumber(std::get<ImmediateAssignInstruction>(initIns).value);
+    } else if (std::holds_alternative<RegisterAssignInstruction>(initIns)) {
+        initial = a.constantOf(std::get<RegisterAssignInstruction>(initIns).rhs);
+    }
+    // a counter starting at -0 is +0 once reduced
+    if (!initial || !isExactStep(*initial) || std::signbit(*initial)) return std::nullopt;
+    return BasicInductionVariable{reg, update, increment, *initial, *step};
+}
+
+// whether the counter takes the value 0: initial + k * step for some k >= 0 (exact, see isExactStep)
+bool reachesZero(const BasicInductionVariable &iv) {
+    if (iv.initial == 0 || iv.step == 0) return iv.initial == 0;
+    double k = -iv.initial / iv.step;
+    return k >= 0 && k == std::floor(k);
+}
+
+// whether j = i * scale, kept as a running sum, has the sign of zero that i * scale has: a sum that
+//  comes out 0 is +0, while i * scale is -0 at i = 0 for a negative scale, and takes the sign of i for
+//  a zero scale
+bool keepsSignOfZero(double scale, const BasicInductionVariable &iv) {
+    if (scale == 0) return false;
+    return scale > 0 || !reachesZero(iv);
+}
+
+// j = i * s (number) or j = vmul(v, i * s) (constant vector); both advance by a constant when i does
+struct DerivedInductionVariable {
+    bool isVector;
+    std::vector<double> scale;  // s, or the components of v * s
+    VReg reg;
+    std::optional<VReg> stepReg;
+};
+
+// scale of a derived induction variable computed by instruction i; `counterScale` maps registers
+//  already known to hold i * s (copies of i hold i * 1)
+std::optional<std::vector<double>> matchScale(InductionAnalysis &a, const BasicInductionVariable &iv, size_t i,
+                                              const std::map<VReg, double> &counterScale, bool &isVector) {
+    auto &ins = a.ir.instructions[i];
+    if (!std::holds_alternative<GenericWriteInstruction>(ins)) return std::nullopt;
+    auto &rhs = std::get<GenericWriteInstruction>(ins).rhs;
+    if (rhs.size() != 3 || !a.isSingleDef(std::get<GenericWriteInstruction>(ins).lhs)) return std::nullopt;
+    auto &opcode = std::get<std::string>(rhs[0]);
+    auto scaleOf = [&](const std::variant<VReg, std::string> &operand) -> std::optional<double> {
+        if (!std::holds_alternative<VReg>(operand)) return std::nullopt;
+        auto reg = std::get<VReg>(operand);
+        if (a.copiedFrom(reg) == iv.reg && a.inLoop(a.definition[reg])) return 1;
+        auto it = counterScale.find(reg);
+        return it == counterScale.end() ? std::nullopt : std::make_optional(it->second);
+    };
+
+    std::vector<double> scale;
+    if (opcode == "mul" && (scaleOf(rhs[1]) || scaleOf(rhs[2]))) {
+        bool counterFirst = scaleOf(rhs[1]).has_value();
+        auto s = a.constantOf(counterFirst ? rhs[2] : rhs[1]);
+        if (!s) return std::nullopt;
+        scale = {*s * *scaleOf(counterFirst ? rhs[1] : rhs[2])};
+        isVector = false;
+    } else if (opcode == "vmul" && scaleOf(rhs[2]) && std::holds_alternative<VReg>(rhs[1])) {
+        auto v = std::get<VReg>(rhs[1]);
+        if (!a.isSingleDef(v)) return std::nullopt;
+        auto &def = a.ir.instructions[a.definition[v]];
+        if (!std::holds_alternative<GenericWriteInstruction>(def)) return std::nullopt;
+        auto &components = std::get<GenericWriteInstruction>(def).rhs;
+        if (std::get<std::string>(components[0]) != "makevec" || components.size() != 4) return std::nullopt;
+        for (size_t c = 1; c < components.size(); c++) {
+            auto value = a.constantOf(components[c]);
+            if (!value) return std::nullopt;
+            scale.push_back(*value * *scaleOf(rhs[2]));
+        }
+        isVector = true;
+    } else {
+        return std::nullopt;
+    }
+    for (auto s: scale) {
+        if (!isExactStep(s) || !keepsSignOfZero(s, iv)) return std::nullopt;
+    }
+    return scale;
+}
+
+bool readsRegister(const Instruction &ins, VReg reg) {
+    for (auto r: readRegisters(ins)) {
+        if (r == reg) return true;
+    }
+    return false;
+}
+
+// edits found in one sweep, by position in the program as it was analysed
+struct ProgramEdits {
+    std::map<size_t, std::vector<Instruction>> insertBefore;
+    std::map<size_t, std::vector<Instruction>> insertAfter;
+    std::map<size_t, Instruction> replace;
+    std::vector<bool> removed;
+};
+
+// finds the rewrite of one loop and adds it to `edits`; returns false if nothing changed
+bool reduceLoop(IR &ir, const ControlFlowGraph &cfg, const DominatorTree &idom, ProgramFacts &facts, const Loop &loop,
+                ProgramEdits &edits) {
+    auto position = findPreheaderPosition(ir, cfg, loop);
+    if (!position) return false;
+    InductionAnalysis a(ir, cfg, idom, facts, loop);
+
+    std::vector<Instruction> preheader;
+    auto &insertAfter = edits.insertAfter;
+    auto &replace = edits.replace;
+    auto &removed = edits.removed;
+
+    for (auto &[reg, defs]: a.defsInLoop) {
+        auto iv = matchBasicInductionVariable(a, reg);
+        if (!iv) continue;
+
+        std::map<std::pair<bool, std::vector<double>>, DerivedInductionVariable> derived;
+        std::map<VReg, double> counterScale;
+        std::map<size_t, VReg> reducedTo;   // instruction => derived register now holding its result
+        for (auto block: loop.blocks) {
+            for (auto i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) {
+                if (replace.count(i) || removed[i]) continue;
+                bool isVector;
+                auto scale = matchScale(a, *iv, i, counterScale, isVector);
+                if (!scale) continue;
+                auto key = std::make_pair(isVector, *scale);
+                if (!derived.count(key)) {
+                    DerivedInductionVariable j{isVector, *scale, ir.generateNewReg(), std::nullopt};
+                    if (isVector) {
+                        j.stepReg = ir.generateNewReg();
+                        GenericWriteInstruction start(j.reg, {"makevec"});
+                        GenericWriteInstruction step(*j.stepReg, {"makevec"});
+                        for (auto s: *scale) {
+                            start.rhs.push_back(formatNumber(s * iv->initial));
+                            step.rhs.push_back(formatNumber(s * iv->step));
+                        }
+                        preheader.push_back(start);
+                        preheader.push_back(step);
+                        insertAfter[iv->update].push_back(GenericWriteInstruction(j.reg, {"vadd", j.reg, *j.stepReg}));
+                    } else {
+                        preheader.push_back(ImmediateAssignInstruction(j.reg, formatNumber(scale->at(0) * iv->initial)));
+                        insertAfter[iv->update].push_back(GenericWriteInstruction(j.reg, {"add", j.reg, formatNumber(scale->at(0) * iv->step)}));
+                    }
+                    derived.emplace(key, j);
+                }
+                auto lhs = *writtenRegister(ir.instructions[i]);
+                if (!isVector) counterScale[lhs] = scale->at(0);
+                reducedTo[i] = derived.at(key).reg;
+                replace.emplace(i, RegisterAssignInstruction(lhs, derived.at(key).reg));
+            }
+        }
+
+        // read the derived register directly where it cannot have advanced since the reduced instruction
+        for (auto &[i, j]: reducedTo) {
+            auto lhs = *writtenRegister(ir.instructions[i]);
+            bool allForwarded = true;
+            for (auto use: a.uses[lhs]) {
+                if (reducedTo.count(use)) continue;     // replaced itself, no longer reads lhs
+                bool advances = cfg.blockOf[iv->update] == cfg.blockOf[i] && i < iv->update && iv->update < use;
+                if (cfg.blockOf[use] != cfg.blockOf[i] || use < i || advances) {
+                    allForwarded = false;
+                    continue;
+                }
+                auto ins = replace.count(use) ? replace.at(use) : ir.instructions[use];
+                visitVReg(ins, [&](VReg &r) { if (r == lhs) r = j; }, [](VReg &) {});
+                replace.insert_or_assign(use, ins);
+            }
+            if (allForwarded) removed[i] = true;
+        }
+        if (derived.empty()) continue;
+
+        // linear function test replacement: tests of the counter against a constant (the loop
+        //  condition is lowered as a jump in the header that computes a flag) compare the scaled
+        //  counter against a scaled bound instead
+        for (auto &[key, j]: derived) {
+            if (j.isVector || j.scale[0] == 0) continue;
+            auto s = j.scale[0];
+            for (auto block: loop.blocks) {
+                auto last = cfg.blocks[block].end - 1;
+                auto &ins = ir.instructions[last];
+                if (!jumpTargetOf(ins) || replace.count(last)) continue;
+                auto list = std::get<GenericReadInstruction>(ins).instruction;
+                if (list.size() != 4) continue;
+                for (size_t k = 2; k < 4; k++) {
+                    auto other = list[5 - k];
+                    auto bound = a.constantOf(other);
+                    if (!std::holds_alternative<VReg>(list[k]) || !bound || !isExactStep(*bound)) continue;
+                    auto copy = std::get<VReg>(list[k]);
+                    auto copyDef = a.definition[copy];
+                    if (a.copiedFrom(copy) != iv->reg || cfg.blockOf[copyDef] != block) continue;
+                    if (cfg.blockOf[iv->update] == block && copyDef < iv->update) continue;
+                    list[k] = j.reg;
+                    list[5 - k] = formatNumber(*bound * s);
+                    if (s < 0) {
+                        auto &opcode = std::get<std::string>(list[0]);
+                        if (opcode == "jmpl") opcode = "jmpg";
+                        else if (opcode == "jmpg") opcode = "jmpl";
+                        else if (opcode == "jmple") opcode = "jmpge";
+                        else if (opcode == "jmpge") opcode = "jmple";
+                    }
+                    replace.emplace(last, GenericReadInstruction(list));
+                    break;
+                }
+            }
+        }
+
+        // i is dead once every read of it is a copy that only feeds its own increment
+        bool isDead = true;
+        std::vector<size_t> copies;
+        for (auto use: a.uses[iv->reg]) {
+            auto copy = writtenRegister(ir.instructions[use]);
+            if (!copy || a.copiedFrom(*copy) != iv->reg || !a.isSingleDef(*copy)) {
+                isDead = false;
+                break;
+            }
+            for (auto copyUse: a.uses[*copy]) {
+                auto r = replace.find(copyUse);
+                bool stillReads = !removed[copyUse] && (r == replace.end() || readsRegister(r->second, *copy));
+                if (copyUse != iv->increment && stillReads) isDead = false;
+            }
+            copies.push_back(use);
+        }
+        if (isDead) {
+            removed[iv->update] = removed[iv->increment] = true;
+            for (auto copy: copies) removed[copy] = true;
+        }
+    }
+    if (preheader.empty()) return false;
+    edits.insertBefore[*position] = std::move(preheader);
+    return true;
+}
+
+IR reduceInductionVariables(const IR &old) {
+    IR ir = old;
+    // every loop gets one rewrite. a sweep analyses the program once and rewrites every loop that does
+    //  not contain one already rewritten in the sweep, so the number of sweeps grows with the nesting
+    //  depth rather than the loop count
+    std::set<std::string> done;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        auto cfg = generateCFG(ir);
+        auto idom = generateDominatorTree(cfg);
+        ProgramFacts facts(ir);
+        ProgramEdits edits;
+        edits.removed.resize(ir.instructions.size());
+        auto loops = findNaturalLoops(cfg, idom);
+        // an inner loop's header comes after its outer loop's
+        std::sort(loops.begin(), loops.end(), [](auto &a, auto &b) { return a.header > b.header; });
+        std::optional<std::pair<size_t, size_t>> lastChanged;
+        for (auto &loop: loops) {
+            auto header = labelOf(ir.instructions[cfg.blocks[loop.header].begin]);
+            if (!header || done.count(*header)) continue;
+            auto first = cfg.blocks[*loop.blocks.begin()].begin;
+            auto last = cfg.blocks[*loop.blocks.rbegin()].end;
+            // left for the next sweep, which sees the rewritten inner loop
+            if (lastChanged && lastChanged->first < last && first < lastChanged->second) continue;
+            done.insert(*header);
+            if (reduceLoop(ir, cfg, idom, facts, loop, edits)) {
+                lastChanged = {first, last};
+                changed = true;
+            }
+        }
+        if (!changed) break;
+
+        Instructions instructions;
+        instructions.reserve(ir.instructions.size() + edits.insertAfter.size());
+        for (size_t i = 0; i < ir.instructions.size(); i++) {
+            auto before = edits.insertBefore.find(i);
+            if (before != edits.insertBefore.end()) {
+                instructions.insert(instructions.end(), before->second.begin(), before->second.end());
+            }
+            if (!edits.removed[i]) {
+                auto r = edits.replace.find(i);
+                instructions.push_back(r == edits.replace.end() ? ir.instructions[i] : r->second);
+            }
+            auto after = edits.insertAfter.find(i);
+            if (after != edits.insertAfter.end()) {
+                instructions.insert(instructions.end(), after->second.begin(), after->second.end());
+            }
+        }
+        ir.instructions = std::move(instructions);
+    }
+    return ir;
+}
@@ -0,0 +1,10 @@
+#ifndef INDUCTION_HH
+#define INDUCTION_HH
+#include <std20c/ir.hh>
+
+// induction-variable strength reduction: in loops counting by a constant step, replaces
+//  `i * s` and `vmul(v, i * s)` with running sums advanced next to the counter, and rewrites
+//  exit tests on the counter in terms of those sums so an otherwise unused counter disappears
+IR reduceInductionVariables(const IR &ir);
+
+#endif
@@ -0,0 +1,130 @@
+#include "licm.hh"
+#include "cfg.hh"
+#include "effects.hh"
+#include "liveness.hh"
+#include "loops.hh"
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+
+// picks what moves out of a single loop, marking it in `hoisted` and returning it in program order;
+//  the analyses describe the program as it was before any loop of this sweep was hoisted from
+std::vector<Instruction> hoistLoop(const IR &ir, const ControlFlowGraph &cfg, const DominatorTree &idom,
+                                   const Liveness &liveness, const std::map<VReg, size_t> &defsInProgram, const Loop &loop,
+                                   std::vector<bool> &hoisted) {
+    std::map<VReg, size_t> defsInLoop;
+    bool loopChangesWorld = false;
+    for (auto block: loop.blocks) {
+        for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) {
+            auto &ins = ir.instructions[i];
+            if (auto reg = writtenRegister(ins)) defsInLoop[*reg]++;
+            auto effect = instructionEffect(ins);
+            if (effect == WORLD_WRITE_EFFECT || effect == SUSPEND_EFFECT) loopChangesWorld = true;
+        }
+    }
+    auto dominatesExits = [&](size_t block) {
+        for (auto exiting: loop.exiting) {
+            if (!dominates(idom, block, exiting)) return false;
+        }
+        return true;
+    };
+    // something another part of the world sees: a trap may not move ahead of it, or the spell would
+    //  abort before it happens instead of after
+    auto isObservable = [&](const Instruction &ins) {
+        auto effect = instructionEffect(ins);
+        return effect == OUTPUT_EFFECT || effect == WORLD_WRITE_EFFECT || effect == SUSPEND_EFFECT;
+    };
+    // blocks an observable instruction can run before in the same iteration, on some path from the header
+    std::set<size_t> afterObservable;
+    std::vector<size_t> worklist{loop.header};
+    while (!worklist.empty()) {
+        auto block = worklist.back();
+        worklist.pop_back();
+        bool observable = block != loop.header && afterObservable.count(block);
+        for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end && !observable; i++) {
+            observable = isObservable(ir.instructions[i]);
+        }
+        if (!observable) continue;
+        for (auto succ: cfg.blocks[block].successors) {
+            if (succ != loop.header && loop.contains(succ) && afterObservable.insert(succ).second) worklist.push_back(succ);
+        }
+    }
+
+    std::vector<Instruction> preheader;
+    for (auto block: loop.blocks) {
+        bool observedBefore = afterObservable.count(block);
+        for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) {
+            auto &ins = ir.instructions[i];
+            if (isObservable(ins)) observedBefore = true;
+            auto lhs = writtenRegister(ins);
+            // only single-definition registers: nothing else can observe the value changing
+            if (!lhs || defsInProgram.at(*lhs) != 1 || liveness.liveIn[loop.header].count(*lhs)) continue;
+
+            bool invariantOperands = true;
+            for (auto reg: readRegisters(ins)) {
+                if (defsInLoop[reg] != 0) invariantOperands = false;
+            }
+            if (!invariantOperands) continue;
+
+            auto effect = instructionEffect(ins);
+            bool movable = (effect == PURE_EFFECT || (effect == WORLD_READ_EFFECT && !loopChangesWorld))
+                && (!mayTrap(ins) || (dominatesExits(block) && !observedBefore));
+            if (!movable) continue;
+
+            hoisted[i] = true;
+            defsInLoop[*lhs]--;
+            preheader.push_back(ins);
+        }
+    }
+    return preheader;
+}
+
+IR hoistLoopInvariants(const IR &old) {
+    IR ir = old;
+    // a sweep analyses the program once and hoists out of every loop that does not contain one already
+    //  hoisted from in the sweep; innermost loops go first so their invariants keep moving outwards in
+    //  the sweeps after, and the number of sweeps grows with the nesting depth rather than the loop count
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        auto cfg = generateCFG(ir);
+        auto idom = generateDominatorTree(cfg);
+        auto liveness = generateLiveness(ir, cfg);
+        std::map<VReg, size_t> defsInProgram;
+        for (auto &ins: ir.instructions) {
+            if (auto reg = writtenRegister(ins)) defsInProgram[*reg]++;
+        }
+        auto loops = findNaturalLoops(cfg, idom);
+        // an inner loop's header comes after its outer loop's
+        std::sort(loops.begin(), loops.end(), [](auto &a, auto &b) { return a.header > b.header; });
+        std::vector<bool> hoisted(ir.instructions.size());
+        std::map<size_t, std::vector<Instruction>> preheaders;
+        std::optional<std::pair<size_t, size_t>> lastChanged;
+        for (auto &loop: loops) {
+            auto first = cfg.blocks[*loop.blocks.begin()].begin;
+            auto last = cfg.blocks[*loop.blocks.rbegin()].end;
+            if (lastChanged && lastChanged->first < last && first < lastChanged->second) continue;
+            auto position = findPreheaderPosition(ir, cfg, loop);
+            if (!position) continue;
+            auto preheader = hoistLoop(ir, cfg, idom, liveness, defsInProgram, loop, hoisted);
+            if (preheader.empty()) continue;
+            preheaders[*position] = std::move(preheader);
+            lastChanged = {first, last};
+            changed = true;
+        }
+        if (!changed) break;
+
+        Instructions instructions;
+        instructions.reserve(ir.instructions.size());
+        for (size_t i = 0; i < ir.instructions.size(); i++) {
+            auto preheader = preheaders.find(i);
+            if (preheader != preheaders.end()) {
+                instructions.insert(instructions.end(), preheader->second.begin(), preheader->second.end());
+            }
+            if (!hoisted[i]) instructions.push_back(std::move(ir.instructions[i]));
+        }
+        ir.instructions = std::move(instructions);
+    }
+    return ir;
+}
@@ -0,0 +1,10 @@
+#ifndef LICM_HH
+#define LICM_HH
+#include <std20c/ir.hh>
+
+// loop-invariant code motion: moves computations whose operands do not change inside a loop
+//  (literals, pure builtins, and world queries in loops that never write the world or wait)
+//  in front of the loop header so they run once instead of every iteration
+IR hoistLoopInvariants(const IR &ir);
+
+#endif
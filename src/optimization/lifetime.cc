@@ -1,39 +1,57 @@
 #include "lifetime.hh"
+#include "cfg.hh"
+#include "liveness.hh"
 #include "std20c/ir.hh"
+#include <algorithm>
 #include <cstddef>
 #include <map>
-#include <optional>
 
 
 LifeTimeChart generateLifetimes(const IR& ir) {
     LifeTimeChart chart(ir.instructions.size());
-    std::map<VReg, size_t> lastWrite;
-    std::map<VReg, std::optional<size_t>> lastRead;
-    auto registerIsRead = [&](VReg reg, size_t position) {
-        lastRead[reg] = position;
-    };
-    auto registerIsWritten = [&](VReg reg, size_t position) {
-        if (lastRead[reg].has_value()) {
-            // register was read in the past before it is written
-            chart.registersBecomingAlive[lastWrite[reg]].push_back(reg);   // alive when it was written initially
-            chart.registersBecomingDead[*lastRead[reg]].push_back(reg);    // dead last time it was read
+    auto cfg = generateCFG(ir);
+    auto liveness = generateLiveness(ir, cfg);
+
+    // a register keeps its slot over the hull of every position it is written, read or live across;
+    //  liveness comes from the cfg, so values carried around loops stay allocated over the whole loop
+    std::map<VReg, std::pair<size_t, size_t>> hull;
+    auto extend = [&](VReg reg, size_t first, size_t last) {
+        auto [it, inserted] = hull.try_emplace(reg, first, last);
+        if (!inserted) {
+            it->second.first = std::min(it->second.first, first);
+            it->second.second = std::max(it->second.second, last);
         }
-        lastRead[reg] = std::nullopt;   // reset read
-        lastWrite[reg] = position;      // new written now
     };
-
-    for (auto &e: ir.virtualRegisters) {
-        lastWrite.emplace(e, 0);
-        lastRead.emplace(e, std::optional<size_t>());
-    }
-    for (size_t i = 0; i < ir.instructions.size(); i++) {
-        auto &ins = ir.instructions[i];
-        visitVReg(ins, 
-            [&](const VReg &v){ registerIsRead(v, i); }, 
-            [&](const VReg &v){ registerIsWritten(v, i); });
+    for (size_t b = 0; b < cfg.blocks.size(); b++) {
+        auto &block = cfg.blocks[b];
+        for (auto reg: liveness.liveIn[b]) {
+            extend(reg, block.begin, block.begin);
+        }
+        for (auto reg: liveness.liveOut[b]) {
+            // must survive the last instruction of the block
+            extend(reg, block.end == block.begin ? block.begin : block.end - 1, block.end);
+        }
+        for (size_t i = block.begin; i < block.end; i++) {
+            for (auto reg: readRegisters(ir.instructions[i])) {
+                extend(reg, i, i);
+            }
+            // a result nobody reads (only left by calls with effects) still needs somewhere to be written
+            if (auto reg = writtenRegister(ir.instructions[i])) {
+                extend(*reg, i, i);
+            }
+        }
     }
-    for (auto &e: ir.virtualRegisters) {
-        registerIsWritten(e, ir.instructions.size());
+
+    for (auto &[reg, interval]: hull) {
+        auto [first, last] = interval;
+        // only touched by a single instruction; it still needs a slot during that instruction
+        if (first == last) last++;
+        if (first < chart.registersBecomingAlive.size()) {
+            chart.registersBecomingAlive[first].push_back(reg);
+        }
+        if (last < chart.registersBecomingDead.size()) {
+            chart.registersBecomingDead[last].push_back(reg);
+        }
     }
     return chart;
-}
\ No newline at end of file
+}
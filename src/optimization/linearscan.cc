@@ -1,4 +1,5 @@
 #include "linearscan.hh"
+#include <algorithm>
 #include <cassert>
 #include <optional>
 
@@ -16,6 +17,15 @@ void RegisterAllocationState::allocateReg(VReg v) {
     oldRegToNewReg.emplace(v, free.back());
     free.pop_back();
 }
+void RegisterAllocationState::allocateFixedReg(VReg v, VReg newReg) {
+    while (maxRegisters <= newReg) {
+        free.insert(free.begin(), maxRegisters++);
+    }
+    auto it = std::find(free.begin(), free.end(), newReg);
+    assert((it != free.end() && "allocateFixedReg: register already in use"));
+    free.erase(it);
+    oldRegToNewReg.emplace(v, newReg);
+}
 void RegisterAllocationState::deallocateReg(VReg v) {  
     free.push_back(*this->lookupNewReg(v));
 }
@@ -14,6 +14,8 @@ public:
     std::optional<VReg> lookupNewReg(VReg reg) const;
     // allocates a register that currently is not used; increases maxRegisters if not enough
     void allocateReg(VReg v);
+    // allocates a specific register (must currently be unused); used for std20's predefined slots
+    void allocateFixedReg(VReg v, VReg newReg);
     // deallocates a register
     // note: if double free => UB; this is maintained by class invariance
     void deallocateReg(VReg v);
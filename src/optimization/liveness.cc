@@ -0,0 +1,39 @@
+#include "liveness.hh"
+
+Liveness generateLiveness(const IR &ir, const ControlFlowGraph &cfg) {
+    auto n = cfg.blocks.size();
+    // use => read before written in the block, def => written in the block
+    std::vector<std::set<VReg>> use(n), def(n);
+    for (std::size_t b = 0; b < n; b++) {
+        for (auto i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            for (auto v: readRegisters(ir.instructions[i])) {
+                if (!def[b].count(v)) use[b].insert(v);
+            }
+            if (auto v = writtenRegister(ir.instructions[i])) {
+                def[b].insert(*v);
+            }
+        }
+    }
+
+    Liveness liveness{std::vector<std::set<VReg>>(n), std::vector<std::set<VReg>>(n)};
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto b = n; b-- > 0;) {
+            std::set<VReg> out;
+            for (auto succ: cfg.blocks[b].successors) {
+                out.insert(liveness.liveIn[succ].begin(), liveness.liveIn[succ].end());
+            }
+            std::set<VReg> in = use[b];
+            for (auto v: out) {
+                if (!def[b].count(v)) in.insert(v);
+            }
+            if (in != liveness.liveIn[b] || out != liveness.liveOut[b]) {
+                liveness.liveIn[b] = std::move(in);
+                liveness.liveOut[b] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+    return liveness;
+}
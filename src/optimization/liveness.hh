@@ -0,0 +1,14 @@
+#ifndef LIVENESS_HH
+#define LIVENESS_HH
+#include "cfg.hh"
+#include <set>
+#include <vector>
+
+// registers whose current value may still be read, at the boundaries of every block
+struct Liveness {
+    std::vector<std::set<VReg>> liveIn;
+    std::vector<std::set<VReg>> liveOut;
+};
+Liveness generateLiveness(const IR &, const ControlFlowGraph &);
+
+#endif
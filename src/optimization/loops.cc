@@ -0,0 +1,152 @@
+#include "loops.hh"
+#include <algorithm>
+#include <map>
+
+
+std::vector<std::size_t> reversePostorder(const ControlFlowGraph &cfg) {
+    std::vector<std::size_t> order;
+    std::vector<bool> visited(cfg.blocks.size());
+    // iterative dfs; a deep chain of blocks should not blow the stack
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto &[block, next] = stack.back();
+        auto &successors = cfg.blocks[block].successors;
+        if (next < successors.size()) {
+            auto succ = successors[next++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            order.push_back(block);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// "A Simple, Fast Dominance Algorithm" (Cooper, Harvey, Kennedy)
+DominatorTree generateDominatorTree(const ControlFlowGraph &cfg) {
+    auto order = reversePostorder(cfg);
+    std::vector<std::size_t> rpoIndex(cfg.blocks.size(), noDominator);
+    for (std::size_t i = 0; i < order.size(); i++) {
+        rpoIndex[order[i]] = i;
+    }
+    std::vector<std::size_t> idom(cfg.blocks.size(), noDominator);
+    idom[0] = 0;
+    auto intersect = [&](std::size_t a, std::size_t b) {
+        while (a != b) {
+            while (rpoIndex[a] > rpoIndex[b]) a = idom[a];
+            while (rpoIndex[b] > rpoIndex[a]) b = idom[b];
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto block: order) {
+            if (block == 0) continue;
+            std::size_t newIdom = noDominator;
+            for (auto pred: cfg.blocks[block].predecessors) {
+                if (idom[pred] == noDominator) continue;
+                newIdom = newIdom == noDominator ? pred : intersect(pred, newIdom);
+            }
+            if (idom[block] != newIdom) {
+                idom[block] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    // walking up from b to a costs the depth of the tree, which grows with the length of straight-line
+    //  code; numbering it once makes every query constant time
+    DominatorTree tree{idom, std::vector<std::size_t>(cfg.blocks.size()), std::vector<std::size_t>(cfg.blocks.size())};
+    std::vector<std::vector<std::size_t>> children(cfg.blocks.size());
+    for (std::size_t b = 1; b < cfg.blocks.size(); b++) {
+        if (idom[b] != noDominator) children[idom[b]].push_back(b);
+    }
+    std::size_t clock = 0;
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{0, 0}};
+    tree.enter[0] = clock++;
+    while (!stack.empty()) {
+        auto &[block, next] = stack.back();
+        if (next < children[block].size()) {
+            auto child = children[block][next++];
+            tree.enter[child] = clock++;
+            stack.emplace_back(child, 0);
+        } else {
+            tree.leave[block] = clock++;
+            stack.pop_back();
+        }
+    }
+    return tree;
+}
+
+bool dominates(const DominatorTree &tree, std::size_t a, std::size_t b) {
+    if (tree[a] == noDominator || tree[b] == noDominator) return false;
+    return tree.enter[a] <= tree.enter[b] && tree.leave[b] <= tree.leave[a];
+}
+
+std::vector<Loop> findNaturalLoops(const ControlFlowGraph &cfg, const DominatorTree &idom) {
+    std::map<std::size_t, Loop> headerToLoop;
+    for (std::size_t block = 0; block < cfg.blocks.size(); block++) {
+        for (auto succ: cfg.blocks[block].successors) {
+            if (!dominates(idom, succ, block)) continue;
+            // back edge block -> succ; walk predecessors up to the header
+            auto &loop = headerToLoop.try_emplace(succ, Loop{succ, {succ}, {}, {}, {}}).first->second;
+            loop.latches.push_back(block);
+            std::vector<std::size_t> worklist{block};
+            while (!worklist.empty()) {
+                auto b = worklist.back();
+                worklist.pop_back();
+                if (!loop.blocks.insert(b).second) continue;
+                for (auto pred: cfg.blocks[b].predecessors) {
+                    if (idom[pred] != noDominator) worklist.push_back(pred);
+                }
+            }
+        }
+    }
+
+    std::vector<Loop> loops;
+    for (auto &[header, loop]: headerToLoop) {
+        std::set<std::size_t> exits;
+        for (auto b: loop.blocks) {
+            bool isExiting = false;
+            for (auto succ: cfg.blocks[b].successors) {
+                if (!loop.contains(succ)) {
+                    exits.insert(succ);
+                    isExiting = true;
+                }
+            }
+            if (isExiting) loop.exiting.push_back(b);
+        }
+        loop.exits.assign(exits.begin(), exits.end());
+        loops.push_back(std::move(loop));
+    }
+    std::stable_sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    return loops;
+}
+
+std::optional<size_t> findPreheaderPosition(const IR &ir, const ControlFlowGraph &cfg, const Loop &loop) {
+    auto &header = cfg.blocks[loop.header];
+    std::vector<size_t> outside;
+    for (auto pred: header.predecessors) {
+        if (!loop.contains(pred)) outside.push_back(pred);
+    }
+    if (outside.empty()) {
+        return loop.header == 0 ? std::make_optional(header.begin) : std::nullopt;
+    }
+    if (outside.size() != 1) return std::nullopt;
+    auto &pred = cfg.blocks[outside[0]];
+    if (pred.end != header.begin) return std::nullopt;
+    // a jump from the predecessor straight to the header would skip the preheader code
+    if (pred.begin != pred.end) {
+        auto target = jumpTargetOf(ir.instructions[pred.end - 1]);
+        if (target && target == labelOf(ir.instructions[header.begin])) return std::nullopt;
+    }
+    return header.begin;
+}
@@ -0,0 +1,38 @@
+#ifndef LOOPS_HH
+#define LOOPS_HH
+#include "cfg.hh"
+#include <optional>
+#include <set>
+#include <vector>
+
+constexpr std::size_t noDominator = static_cast<std::size_t>(-1);
+// immediate dominator of every block; the entry dominates itself and unreachable blocks map to noDominator
+struct DominatorTree {
+    std::vector<std::size_t> idom;
+    // depth-first numbering of the tree: a dominates b iff a's interval encloses b's
+    std::vector<std::size_t> enter, leave;
+    std::size_t operator[](std::size_t block) const { return idom[block]; }
+};
+DominatorTree generateDominatorTree(const ControlFlowGraph &);
+bool dominates(const DominatorTree &, std::size_t a, std::size_t b);
+
+// blocks in reverse postorder from the entry (unreachable blocks are excluded)
+std::vector<std::size_t> reversePostorder(const ControlFlowGraph &);
+
+// natural loop: all back edges into one header merged together
+struct Loop {
+    std::size_t header;
+    std::set<std::size_t> blocks;       // includes the header
+    std::vector<std::size_t> latches;   // sources of the back edges
+    std::vector<std::size_t> exiting;   // blocks inside the loop with a successor outside
+    std::vector<std::size_t> exits;     // blocks outside the loop with a predecessor inside
+    bool contains(std::size_t block) const { return blocks.count(block) != 0; }
+};
+// innermost loops come first
+std::vector<Loop> findNaturalLoops(const ControlFlowGraph &, const DominatorTree &);
+
+// instruction index code run once before the loop is inserted at: right before the header's label
+//  only exists if the sole way into the loop from outside is falling through into the header
+std::optional<std::size_t> findPreheaderPosition(const IR &, const ControlFlowGraph &, const Loop &);
+
+#endif
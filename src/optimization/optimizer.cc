@@ -1,13 +1,20 @@
 #include "optimizer.hh"
 #include "linearscan.hh"
 #include "lifetime.hh"
+#include "licm.hh"
+#include "gvn.hh"
+#include "induction.hh"
+#include "constprop.hh"
+#include "dce.hh"
+#include "../instrument/phase.hh"
 #include "std20c/ir.hh"
+#include <algorithm>
 #include <cassert>
 #include <variant>
 #include <vector>
 
 
-IR generateOptimizedIR(const IR &old, const LifeTimeChart &lifetimes) {
+IR generateOptimizedIR(const IR &old, const LifeTimeChart &lifetimes, size_t &slots) {
     RegisterAllocationState state;
     IR ir;
     assert((old.instructions.size() == lifetimes.registersBecomingAlive.size() 
@@ -15,38 +22,66 @@ IR generateOptimizedIR(const IR &old, const LifeTimeChart &lifetimes) {
     for (size_t i = 0; i < old.instructions.size(); i++) {
         auto &ins = old.instructions[i];
         auto &nowDead = lifetimes.registersBecomingDead[i];
-        auto &nowAlive = lifetimes.registersBecomingAlive[i];
+        auto nowAlive = lifetimes.registersBecomingAlive[i];
         
         // first remove dead registers
         for (auto dead: nowDead) {
             state.deallocateReg(dead);
         }
-        // add alive
+        // add alive; predefined slots alive at the start keep their number
+        if (i == 0) {
+            std::sort(nowAlive.begin(), nowAlive.end());
+            for (auto alive: nowAlive) {
+                if (alive < reservedRegisters) state.allocateFixedReg(alive, alive);
+            }
+        }
         for (auto alive: nowAlive) {
-            state.allocateReg(alive);
+            if (!state.lookupNewReg(alive)) state.allocateReg(alive);
         }
         auto insCopy = ins;
-        bool isSkippable = false;
         visitVReg(insCopy, [&](VReg &r){
             r = *state.lookupNewReg(r);
         }, [&](VReg &r){
-            if (auto opt = state.lookupNewReg(r)) {
-                r = *opt;
-            } else {
-                isSkippable = true;
-            }
+            r = *state.lookupNewReg(r);
         });
 
-        if (!isSkippable) {
-            ir.instructions.push_back(insCopy);
+        // a copy into the slot it reads from does nothing
+        if (std::holds_alternative<RegisterAssignInstruction>(insCopy)) {
+            auto &assign = std::get<RegisterAssignInstruction>(insCopy);
+            if (assign.lhs == assign.rhs) continue;
         }
-
+        ir.instructions.push_back(insCopy);
     }
 
+    slots = state.maxRegisters;
     return ir;
 }
 
-IR optimizer(const IR &ir) {
-    auto lifetimes = generateLifetimes(ir);
-    return generateOptimizedIR(ir, std::move(lifetimes));
-}
\ No newline at end of file
+IR optimizer(const IR &ir, size_t level, const UnrollCostModel &unroll, OptimizationStats *stats) {
+    IR optimized = ir;
+    auto pass = [&](const char *name, auto &&run) {
+        PhaseScope phase(name);
+        if (!stats) {
+            optimized = run(optimized);
+            return;
+        }
+        auto before = countProgram(optimized);
+        optimized = run(optimized);
+        stats->passes.push_back({name, before, countProgram(optimized)});
+    };
+    pass("constprop", propagateConstants);
+    if (level >= 2) {
+        pass("unroll", [&](const IR &ir) { return unrollLoops(ir, unroll); });
+    }
+    pass("gvn", eliminateCommonSubexpressions);
+    if (level >= 2) {
+        pass("licm", hoistLoopInvariants);
+        pass("induction", reduceInductionVariables);
+    }
+    pass("dce", eliminateDeadCode);
+    if (stats) stats->pressure = registerPressure(optimized);
+    size_t slots;
+    pass("regalloc", [&](const IR &ir) { return generateOptimizedIR(ir, generateLifetimes(ir), slots); });
+    if (stats) stats->slots = slots;
+    return optimized;
+}
@@ -1,7 +1,12 @@
 #ifndef OPTIMIZER_HH
 #define OPTIMIZER_HH
 #include <std20c/ir.hh>
+#include "stats.hh"
+#include "unroll.hh"
 
-IR optimizer(const IR &ir);
+// level 1 => constant propagation + value numbering + register allocation,
+//  level 2 => loop optimizations (unrolling within the cost model, LICM, strength reduction) as well;
+//  what every pass did goes to `stats` if given
+IR optimizer(const IR &ir, size_t level, const UnrollCostModel &unroll, OptimizationStats *stats = nullptr);
 
 #endif
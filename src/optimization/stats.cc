@@ -0,0 +1,61 @@
+#include "stats.hh"
+#include "effects.hh"
+#include "lifetime.hh"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+std::vector<std::size_t> registerPressure(const IR &ir) {
+    auto lifetimes = generateLifetimes(ir);
+    std::vector<std::size_t> pressure;
+    std::size_t live = 0;
+    for (size_t i = 0; i < ir.instructions.size(); i++) {
+        live -= lifetimes.registersBecomingDead[i].size();
+        live += lifetimes.registersBecomingAlive[i].size();
+        pressure.push_back(live);
+    }
+    return pressure;
+}
+
+ProgramCounts countProgram(const IR &ir) {
+    ProgramCounts counts;
+    counts.instructions = ir.instructions.size();
+    for (auto &ins: ir.instructions) {
+        auto opcode = opcodeOf(ins);
+        if (opcode == "label") counts.labels++;
+        else if (opcode != "mov" && opcode.rfind("jmp", 0) != 0) counts.builtinCalls++;
+    }
+    auto pressure = registerPressure(ir);
+    counts.maxLive = pressure.empty() ? 0 : *std::max_element(pressure.begin(), pressure.end());
+    return counts;
+}
+
+void printOptimizationStats(std::ostream &os, const OptimizationStats &stats) {
+    char line[160];
+    // every column is the count before the pass, and after it if the pass changed it
+    std::snprintf(line, sizeof(line), "%-10s %14s %14s %14s %14s\n", "pass", "instructions", "labels", "builtins", "max live");
+    os << line;
+    for (auto &pass: stats.passes) {
+        auto change = [](std::size_t before, std::size_t after) {
+            return std::to_string(before) + (after == before ? "" : " -> " + std::to_string(after));
+        };
+        std::snprintf(line, sizeof(line), "%-10s %14s %14s %14s %14s\n", pass.pass.c_str(),
+                      change(pass.before.instructions, pass.after.instructions).c_str(),
+                      change(pass.before.labels, pass.after.labels).c_str(),
+                      change(pass.before.builtinCalls, pass.after.builtinCalls).c_str(),
+                      change(pass.before.maxLive, pass.after.maxLive).c_str());
+        os << line;
+    }
+    os << "slots: " << stats.slots << "\n";
+
+    // positions per number of live registers, as bars of at most 50 marks
+    std::map<std::size_t, std::size_t> histogram;
+    for (auto live: stats.pressure) histogram[live]++;
+    std::size_t most = 0;
+    for (auto &[live, positions]: histogram) most = std::max(most, positions);
+    os << "register pressure (live registers: instructions)\n";
+    for (auto &[live, positions]: histogram) {
+        std::snprintf(line, sizeof(line), "%5zu: %6zu ", live, positions);
+        os << line << std::string((positions * 50 + most - 1) / most, '#') << "\n";
+    }
+}
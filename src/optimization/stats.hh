@@ -0,0 +1,35 @@
+#ifndef STATS_HH
+#define STATS_HH
+#include <std20c/ir.hh>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// counts of one program, as compared before and after every pass
+struct ProgramCounts {
+    std::size_t instructions = 0;
+    std::size_t labels = 0;
+    std::size_t builtinCalls = 0;   // instructions other than mov, labels and jumps
+    std::size_t maxLive = 0;        // most registers live at one instruction
+};
+ProgramCounts countProgram(const IR &);
+
+struct PassStats {
+    std::string pass;
+    ProgramCounts before, after;
+};
+// what optimizer() did, collected when it is given somewhere to put it (-fstats)
+struct OptimizationStats {
+    std::vector<PassStats> passes;
+    std::size_t slots = 0;              // RegisterAllocationState::maxRegisters of the final program
+    std::vector<std::size_t> pressure;  // live registers at each instruction given to the allocator
+};
+
+// registers live at each instruction, counted the way the allocator sees them (see generateLifetimes)
+std::vector<std::size_t> registerPressure(const IR &);
+
+// per-pass table followed by the slot count and a histogram of the register pressure
+void printOptimizationStats(std::ostream &, const OptimizationStats &);
+
+#endif
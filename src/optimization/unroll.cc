@@ -0,0 +1,311 @@
+#include "unroll.hh"
+#include "cfg.hh"
+#include "constprop.hh"
+#include "effects.hh"
+#include "liveness.hh"
+#include "loops.hh"
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+
+// instructions simulated per loop before giving up on its trip count
+constexpr size_t simulationLimit = 1 << 16;
+
+struct TripCount {
+    size_t trips;               // times the back edge is taken
+    size_t exit;                // block control leaves the loop to
+    ConstantState exitState;
+};
+
+// runs the loop on known values from its entry state; fails as soon as a jump depends on anything else
+std::optional<TripCount> countTrips(const IR &ir, const ControlFlowGraph &cfg, const std::map<std::string, size_t> &labelToBlock,
+                                    const Loop &loop, ConstantState state) {
+    size_t trips = 0;
+    size_t steps = 0;
+    auto block = loop.header;
+    while (true) {
+        auto &b = cfg.blocks[block];
+        for (auto i = b.begin; i < b.end; i++) {
+            transferConstants(ir.instructions[i], state);
+        }
+        steps += b.end - b.begin;
+        if (steps > simulationLimit) return std::nullopt;
+        auto next = block + 1;
+        if (b.begin != b.end && jumpTargetOf(ir.instructions[b.end - 1])) {
+            auto &last = ir.instructions[b.end - 1];
+            auto taken = evaluateJump(last, state);
+            if (!taken) return std::nullopt;
+            if (*taken) next = labelToBlock.at(*jumpTargetOf(last));
+        }
+        if (!loop.contains(next)) return TripCount{trips, next, state};
+        if (next == loop.header) trips++;
+        block = next;
+    }
+}
+
+// facts about the whole program, computed once per sweep and shared by every loop tried in it
+struct UnrollAnalysis {
+    ControlFlowGraph cfg;
+    std::vector<std::optional<ConstantState>> states;
+    Liveness liveness;
+    std::map<std::string, size_t> labelToBlock;
+    std::set<std::string> labels;       // grows as copies take fresh labels
+    std::map<VReg, size_t> defs;
+    std::map<VReg, std::vector<size_t>> uses;
+};
+
+UnrollAnalysis analyzeForUnrolling(const IR &ir) {
+    UnrollAnalysis analysis;
+    analysis.cfg = generateCFG(ir);
+    analysis.states = generateConstantStates(ir, analysis.cfg);
+    analysis.liveness = generateLiveness(ir, analysis.cfg);
+    for (size_t b = 0; b < analysis.cfg.blocks.size(); b++) {
+        auto &block = analysis.cfg.blocks[b];
+        if (block.begin == block.end) continue;
+        if (auto label = labelOf(ir.instructions[block.begin])) {
+            analysis.labelToBlock.emplace(*label, b);
+            analysis.labels.insert(*label);
+        }
+    }
+    for (size_t i = 0; i < ir.instructions.size(); i++) {
+        for (auto reg: readRegisters(ir.instructions[i])) analysis.uses[reg].push_back(i);
+        if (auto reg = writtenRegister(ir.instructions[i])) analysis.defs[*reg]++;
+    }
+    return analysis;
+}
+
+// instructions [begin, end) of the program to be replaced
+struct LoopRewrite {
+    size_t begin;
+    size_t end;
+    std::vector<Instruction> replacement;
+};
+
+// the rewrite of one loop, which leaves the program as it is; nothing if the loop is left alone.
+//  `size` is what the program will have grown to once the rewrites found before this one are made
+std::optional<LoopRewrite> unrollLoop(IR &ir, UnrollAnalysis &analysis, const Loop &loop, const UnrollCostModel &model,
+                                      size_t size) {
+    auto &cfg = analysis.cfg;
+    auto &liveness = analysis.liveness;
+    auto &labels = analysis.labels;
+    auto &defs = analysis.defs;
+    auto &uses = analysis.uses;
+    // the shape lowering gives a while loop: one contiguous run of blocks starting at the header's
+    //  label and ending with the only jump back to it, entered by falling into the header
+    if (loop.latches.size() != 1 || !findPreheaderPosition(ir, cfg, loop)) return std::nullopt;
+    auto latch = loop.latches[0];
+    if (latch < loop.header || loop.blocks.size() != latch - loop.header + 1) return std::nullopt;
+    auto begin = cfg.blocks[loop.header].begin;
+    auto end = cfg.blocks[latch].end;
+    auto header = labelOf(ir.instructions[begin]);
+    auto &backJump = ir.instructions[end - 1];
+    if (!header || !isUnconditionalJump(backJump) || jumpTargetOf(backJump) != header) return std::nullopt;
+
+    ConstantState entry;
+    if (loop.header != 0) {
+        auto preheader = cfg.blockOf[begin - 1];
+        if (!analysis.states[preheader]) return std::nullopt;
+        entry = *analysis.states[preheader];
+        for (auto i = cfg.blocks[preheader].begin; i < cfg.blocks[preheader].end; i++) {
+            transferConstants(ir.instructions[i], entry);
+        }
+    }
+    auto tripCount = countTrips(ir, cfg, analysis.labelToBlock, loop, entry);
+    if (!tripCount) return std::nullopt;
+    auto trips = tripCount->trips;
+    auto regionSize = end - begin;
+
+    bool isPure = true;
+    for (auto i = begin; i < end; i++) {
+        auto effect = instructionEffect(ir.instructions[i]);
+        if (effect == CONTROL_EFFECT) continue;
+        if (effect != PURE_EFFECT || mayTrap(ir.instructions[i])) isPure = false;
+    }
+
+    std::vector<Instruction> replacement;
+    bool replaced = false;
+    // a loop that only computes values: its results are already known from the simulation
+    if (isPure) {
+        std::set<VReg> written;
+        for (auto i = begin; i < end; i++) {
+            if (auto reg = writtenRegister(ir.instructions[i])) written.insert(*reg);
+        }
+        bool known = true;
+        for (auto reg: liveness.liveIn[tripCount->exit]) {
+            if (!written.count(reg)) continue;
+            auto value = tripCount->exitState.find(reg);
+            auto assign = value == tripCount->exitState.end() ? std::nullopt : materializeConstant(reg, value->second);
+            if (!assign) {
+                known = false;
+                break;
+            }
+            replacement.push_back(*assign);
+        }
+        if (known && cfg.blocks[tripCount->exit].begin != end) {
+            auto exitLabel = labelOf(ir.instructions[cfg.blocks[tripCount->exit].begin]);
+            replacement.push_back(GenericReadInstruction({"jmpe", *exitLabel, "0", "0"}));
+        }
+        if (!known) replacement.clear();
+        replaced = known;
+    }
+
+    // temporaries defined once and only read later in the same block can get fresh registers per copy
+    std::map<VReg, size_t> locals;
+    for (auto i = begin; i < end; i++) {
+        auto reg = writtenRegister(ir.instructions[i]);
+        if (!reg || *reg < reservedRegisters || defs[*reg] != 1) continue;
+        bool isLocal = true;
+        for (auto use: uses[*reg]) {
+            if (cfg.blockOf[use] != cfg.blockOf[i] || use <= i) isLocal = false;
+        }
+        if (isLocal) locals.emplace(*reg, i);
+    }
+    auto freshLabel = [&](const std::string &base) {
+        for (size_t n = 1;; n++) {
+            auto name = base + "_" + std::to_string(n);
+            if (labels.insert(name).second) return name;
+        }
+    };
+
+    // one iteration without its back jump, starting at `from`; the header is declared as `self` and
+    //  jumps to it go to `next` instead; copies other than the original get their own labels and temporaries
+    auto copyIteration = [&](const std::string &self, const std::string &next, bool isOriginal, size_t from,
+                             std::optional<size_t> droppedExit) {
+        std::map<std::string, std::string> renamed;
+        std::map<VReg, VReg> registers;
+        if (!isOriginal) {
+            for (auto i = begin + 1; i < end; i++) {
+                if (auto label = labelOf(ir.instructions[i])) renamed.emplace(*label, freshLabel(*label));
+            }
+            for (auto &[reg, def]: locals) registers.emplace(reg, ir.generateNewReg());
+        }
+        replacement.push_back(GenericReadInstruction({"label", self}));
+        for (auto i = std::max(from, begin + 1); i < end - 1; i++) {
+            if (i == droppedExit) continue;
+            auto ins = ir.instructions[i];
+            if (labelOf(ins) || jumpTargetOf(ins)) {
+                auto &name = std::get<std::string>(std::get<GenericReadInstruction>(ins).instruction[1]);
+                if (jumpTargetOf(ins) && name == *header) name = next;
+                else if (renamed.count(name)) name = renamed.at(name);
+            }
+            visitVReg(ins, [&](VReg &r) { if (registers.count(r)) r = registers.at(r); },
+                           [&](VReg &r) { if (registers.count(r)) r = registers.at(r); });
+            replacement.push_back(std::move(ins));
+        }
+    };
+
+    // complete unrolling: every iteration is laid out in front of the loop, which is then never entered
+    //  (constant propagation removes it once it sees the exit test fail)
+    if (!replaced && trips > 0 && trips <= model.maxTripCount && trips * regionSize <= model.maxLoopSize
+        && size + trips * regionSize <= model.sizeBudget) {
+        std::vector<std::string> headers;
+        for (size_t copy = 0; copy < trips; copy++) headers.push_back(freshLabel(*header));
+        headers.push_back(*header);
+        for (size_t copy = 0; copy < trips; copy++) {
+            copyIteration(headers[copy], headers[copy + 1], false, begin, std::nullopt);
+        }
+        replacement.insert(replacement.end(), ir.instructions.begin() + begin, ir.instructions.begin() + end);
+        replaced = true;
+    }
+
+    // partial unrolling by a factor dividing the trip count: only every factor-th iteration can be the
+    //  last, so the other copies drop the exit test, and the code computing it if nothing else needs it
+    if (!replaced && loop.exiting.size() == 1) {
+        auto exitJump = cfg.blocks[loop.exiting[0]].end - 1;
+        std::set<std::string> conditionLabels;
+        for (auto i = begin; i <= exitJump; i++) {
+            if (auto label = labelOf(ir.instructions[i])) conditionLabels.insert(*label);
+        }
+        bool skipCondition = true;
+        for (auto i = begin; i < end - 1 && skipCondition; i++) {
+            auto &ins = ir.instructions[i];
+            auto target = jumpTargetOf(ins);
+            if (i > exitJump) {
+                if (target && target != header && conditionLabels.count(*target)) skipCondition = false;
+                continue;
+            }
+            if (i == exitJump || labelOf(ins)) continue;
+            if (target) {
+                if (!conditionLabels.count(*target)) skipCondition = false;
+                continue;
+            }
+            auto reg = writtenRegister(ins);
+            if (!reg || instructionEffect(ins) != PURE_EFFECT || mayTrap(ins) || liveness.liveIn[loop.header].count(*reg)) {
+                skipCondition = false;
+                continue;
+            }
+            for (auto use: uses[*reg]) {
+                if (use < begin || use > exitJump) skipCondition = false;
+            }
+        }
+        auto from = skipCondition ? exitJump + 1 : begin;
+        auto copySize = end - from;
+        for (auto factor = model.maxFactor; factor >= 2; factor--) {
+            if (trips < factor || trips % factor != 0 || regionSize + (factor - 1) * copySize > model.maxLoopSize
+                || size + (factor - 1) * copySize > model.sizeBudget) {
+                continue;
+            }
+            std::vector<std::string> headers{*header};
+            for (size_t copy = 1; copy < factor; copy++) headers.push_back(freshLabel(*header));
+            headers.push_back(*header);
+            copyIteration(headers[0], headers[1], true, begin, std::nullopt);
+            for (size_t copy = 1; copy < factor; copy++) {
+                copyIteration(headers[copy], headers[copy + 1], false, from, exitJump);
+            }
+            replacement.push_back(backJump);
+            replaced = true;
+            break;
+        }
+    }
+    if (!replaced) return std::nullopt;
+    return LoopRewrite{begin, end, std::move(replacement)};
+}
+
+IR unrollLoops(const IR &old, const UnrollCostModel &model) {
+    IR ir = old;
+    if (model.sizeBudget == 0) return ir;
+    // loops are tried innermost first, each one once; its copies are new loops of their own.
+    //  a sweep analyses the program once and rewrites every loop it can that does not contain one
+    //  already rewritten in the sweep, so the cost grows with the nesting depth rather than the loop count
+    std::set<std::string> done;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        auto analysis = analyzeForUnrolling(ir);
+        auto &cfg = analysis.cfg;
+        auto loops = findNaturalLoops(cfg, generateDominatorTree(cfg));
+        // an inner loop's header comes after its outer loop's
+        std::sort(loops.begin(), loops.end(), [](auto &a, auto &b) { return a.header > b.header; });
+        std::vector<LoopRewrite> rewrites;
+        auto size = ir.instructions.size();
+        for (auto &loop: loops) {
+            auto header = labelOf(ir.instructions[cfg.blocks[loop.header].begin]);
+            if (!header || done.count(*header)) continue;
+            auto first = cfg.blocks[*loop.blocks.begin()].begin;
+            auto last = cfg.blocks[*loop.blocks.rbegin()].end;
+            // left for the next sweep, which sees the rewritten inner loop
+            if (!rewrites.empty() && rewrites.back().begin < last && first < rewrites.back().end) continue;
+            done.insert(*header);
+            if (auto rewrite = unrollLoop(ir, analysis, loop, model, size)) {
+                size += rewrite->replacement.size() - (rewrite->end - rewrite->begin);
+                rewrites.push_back(std::move(*rewrite));
+            }
+        }
+        if (rewrites.empty()) break;
+        // found back to front, so each one's positions are still those of the analysed program
+        Instructions instructions;
+        size_t next = 0;
+        for (auto rewrite = rewrites.rbegin(); rewrite != rewrites.rend(); rewrite++) {
+            instructions.insert(instructions.end(), ir.instructions.begin() + next, ir.instructions.begin() + rewrite->begin);
+            instructions.insert(instructions.end(), rewrite->replacement.begin(), rewrite->replacement.end());
+            next = rewrite->end;
+        }
+        instructions.insert(instructions.end(), ir.instructions.begin() + next, ir.instructions.end());
+        ir.instructions = std::move(instructions);
+        ir = propagateConstants(ir);
+        changed = true;
+    }
+    return ir;
+}
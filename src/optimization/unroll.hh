@@ -0,0 +1,19 @@
+#ifndef UNROLL_HH
+#define UNROLL_HH
+#include <std20c/ir.hh>
+#include <cstddef>
+
+// how much code unrolling may spend to save the compare-and-jump of each iteration, in IR instructions
+struct UnrollCostModel {
+    std::size_t maxTripCount = 32;  // loops running more iterations are only unrolled partially
+    std::size_t maxLoopSize = 512;  // size one unrolled loop may grow to
+    std::size_t maxFactor = 4;      // copies of the body per iteration when unrolling partially
+    std::size_t sizeBudget = 4096;  // size the whole program may grow to (0 turns unrolling off)
+};
+
+// unrolls loops whose trip count is known at compile time: loops that only compute values are
+//  replaced by their results, small loops are unrolled completely and larger ones by a factor
+//  dividing their trip count, so the copies in between need no exit test
+IR unrollLoops(const IR &ir, const UnrollCostModel &model);
+
+#endif
@@ -2,16 +2,18 @@
 #define CHART_HH
 #include "state.hh"
 #include <algorithm>
-#include <deque>
 
 class Chart {
     class ChartRow {
-        std::deque<State> row;
+        ArenaDeque<State> row;
     public:
         ChartRow() = default;
         ~ChartRow() = default;
+        // moved, never copied, when the chart grows: the deque keeps its states where backpointers point to
+        ChartRow(ChartRow &&) = default;
+        ChartRow &operator=(ChartRow &&) = default;
         void append(const State &state) {
-            typename std::deque<State>::iterator it = std::find(this->row.begin(), this->row.end(), state);
+            auto it = std::find(this->row.begin(), this->row.end(), state);
             if (it == this->row.end()) {
                 this->row.push_back(state);
             } else {
@@ -22,10 +24,17 @@ class Chart {
         const State &operator[](std::size_t i) const { return row[i]; }
         std::size_t size() const { return row.size(); }
     };
-    std::vector<ChartRow> chart;
+    ArenaVector<ChartRow> chart;
 public:
     Chart(std::size_t n): chart(n+1) {}
     ~Chart() = default;
+    Chart(Chart &&) = default;
+    Chart &operator=(Chart &&) = default;
+    // keeps the first `columns` columns, followed by empty ones up to the column after `n` tokens
+    void reset(std::size_t columns, std::size_t n) {
+        chart.resize(columns);
+        chart.resize(n+1);
+    }
     ChartRow &operator[](std::size_t i) { return chart[i]; }
     const ChartRow &operator[](std::size_t i) const { return chart[i]; }
     std::size_t size() const { return chart.size(); }
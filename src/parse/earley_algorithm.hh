@@ -8,7 +8,12 @@ inline bool skipTokenPredicate(const Token& token) {
     return token.kind == Terminals::SPACE || token.kind == Terminals::COMMENT;
 }
 
+// the tokens the parser sees: `input` without whitespace and comments
+std::vector<Token> stripInput(const std::vector<Token> &input);
 Chart generateEarleyChart(const std::vector<Token> &strippedInput);
+// recomputes the columns of `chart` after column `from`, which (like the ones before it) was computed for
+//  tokens of the same kinds as the first `from` of `strippedInput`; 0 computes the whole chart
+void extendEarleyChart(Chart &chart, const std::vector<Token> &strippedInput, std::size_t from);
 std::optional<Tree> generateParseTree(const std::vector<Token> &strippedInput, const State &state);
 CompilerError generateParseError(const State &lastValidState, const std::vector<Token> &strippedInput);
 
@@ -2,6 +2,13 @@
 
 Chart generateEarleyChart(const std::vector<Token> &input) {
     Chart S(input.size());
+    extendEarleyChart(S, input, 0);
+    return S;
+}
+
+void extendEarleyChart(Chart &S, const std::vector<Token> &input, std::size_t from) {
+    // the columns after `from` are recomputed, starting with the states `from` scans into the next one
+    S.reset(from ? from + 1 : 0, input.size());
 
     auto predict = [&](State &state) {
         for (const auto &p: grammar) {
@@ -30,8 +37,14 @@ Chart generateEarleyChart(const std::vector<Token> &input) {
         }
     };
 
-    S[0].append(State(grammar[0], 0, 0, 0));
-    for (std::size_t k = 0; k <= input.size(); k++) {
+    if (!from) S[0].append(State(grammar[0], 0, 0, 0));
+    for (std::size_t i = 0; from && i < S[from].size(); i++) {
+        auto &state = S[from][i];
+        if (state.dot < state.p.rhs.size() && std::holds_alternative<Terminals>(state.p.rhs[state.dot]) && from < input.size()) {
+            scan(state, input.at(from));
+        }
+    }
+    for (std::size_t k = from ? from + 1 : 0; k <= input.size(); k++) {
         for (size_t i = 0; i < S[k].size(); i++) {
             auto &state = S[k][i];
             if (state.dot < state.p.rhs.size()) {
@@ -46,6 +59,4 @@ Chart generateEarleyChart(const std::vector<Token> &input) {
             }
         }
     }
-
-    return S;
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "earley_algorithm.hh"
 
 std::optional<Tree> generateParseTree(const std::vector<Token> &strippedInput, const State &state) {
-    std::vector<Tree> subtrees;
+    ArenaVector<Tree> subtrees;
     subtrees.reserve(state.p.rhs.size());
     std::size_t pos = state.left;
     for (std::size_t i = 0; i < state.p.rhs.size(); i++) {
@@ -12,7 +12,7 @@ std::optional<Tree> generateParseTree(const std::vector<Token> &strippedInput, c
             auto it = std::find_if(state.backpointer.begin(), state.backpointer.end(), [&](const typename State::BackPointer &bp) { return bp.dot == i; });
             if (it != state.backpointer.end()) {
                 if (std::optional<Tree> res = generateParseTree(strippedInput, it->state)) {
-                    subtrees.push_back(*res); 
+                    subtrees.push_back(std::move(*res));
                 } else {
                     return std::nullopt;
                 }
@@ -22,5 +22,5 @@ std::optional<Tree> generateParseTree(const std::vector<Token> &strippedInput, c
             pos = it->state.right;
         }
     }
-    return Branch(state.p.lhs, state.left, state.right, subtrees);
+    return Branch(state.p.lhs, state.left, state.right, std::move(subtrees));
 };
@@ -0,0 +1,97 @@
+#include "parser.hh"
+#include "earley_algorithm.hh"
+#include "../driver/pool.hh"
+#include <algorithm>
+#include <atomic>
+#include <optional>
+
+// runs have at least this many tokens, so a chart is worth a task, and there are about this many runs per
+//  worker, so one that takes long leaves the others something to steal
+constexpr std::size_t smallestRun = 4096;
+constexpr std::size_t runsPerThread = 4;
+
+// the index after the last token of every top-level statement, by the rule scanStatement uses; empty if a
+//  `)` or `}` closes nothing or the input does not end a statement, which the parse of the whole input
+//  would report
+std::vector<std::size_t> statementEnds(const std::vector<Token> &input) {
+    std::vector<std::size_t> ends;
+    std::size_t depth = 0;
+    for (std::size_t i = 0; i < input.size(); i++) {
+        auto kind = input[i].kind;
+        if (kind == LPAREN || kind == LBPAREN) {
+            depth++;
+        } else if (kind == RPAREN || kind == RBPAREN) {
+            if (!depth) return {};
+            depth--;
+        }
+        if (depth == 0 && (kind == SEMICOLON || kind == RBPAREN) && (i + 1 == input.size() || input[i + 1].kind != ELSE)) {
+            ends.push_back(i + 1);
+        }
+    }
+    if (ends.empty() || ends.back() != input.size()) return {};
+    return ends;
+}
+
+// a copy of `tree` allocated as the caller's allocations are, its tokens counted from `offset`
+Tree shifted(const Tree &tree, std::size_t offset) {
+    if (std::holds_alternative<Token>(tree)) return tree;
+    auto &branch = std::get<Branch>(tree);
+    ArenaVector<Tree> subtrees;
+    subtrees.reserve(branch.subtrees.size());
+    for (auto &subtree: branch.subtrees) subtrees.push_back(shifted(subtree, offset));
+    return Branch(branch.nt, branch.left + offset, branch.right + offset, std::move(subtrees));
+}
+
+std::variant<CompilerError, Tree> parallelEarleyParser(const std::vector<Token> &input, std::size_t threads) {
+    if (std::any_of(input.begin(), input.end(), skipTokenPredicate)) return earleyParser(input);
+    auto ends = statementEnds(input);
+    std::vector<std::size_t> runs {0};   // where every run starts, and the end of the input
+    auto runSize = std::max(smallestRun, input.size() / (std::max<std::size_t>(threads, 1) * runsPerThread));
+    for (auto end: ends) {
+        if (end - runs.back() >= runSize || end == input.size()) runs.push_back(end);
+    }
+    if (runs.size() < 3) return earleyParser(input);
+
+    // every run is parsed in the arena of the worker parsing it, and its statement list copied out to
+    //  the heap before the next run resets the arena; runs after one that failed are not needed
+    std::vector<std::optional<Tree>> lists(runs.size() - 1);
+    std::atomic<std::size_t> firstFailed{lists.size()};
+    std::vector<PoolTask> tasks;
+    for (std::size_t r = 0; r + 1 < runs.size(); r++) {
+        tasks.push_back([&, r](std::size_t) {
+            if (r > firstFailed) return;
+            std::vector<Token> run(input.begin() + runs[r], input.begin() + runs[r + 1]);
+            ArenaScope arena;
+            auto tryParse = earleyParser(run);
+            if (std::holds_alternative<CompilerError>(tryParse)) {
+                for (auto failed = firstFailed.load(); r < failed && !firstFailed.compare_exchange_weak(failed, r);) {}
+                return;
+            }
+            HeapScope heap;
+            lists[r] = shifted(std::get<Branch>(std::get<Tree>(tryParse)).subtrees.at(0), runs[r]);
+        });
+    }
+    runWorkStealing(std::move(tasks), threads);
+
+    // the runs before the first that failed parse, and a statement boundary is one in every parse, so
+    //  parsing on from that run finds the error the whole input would
+    if (auto failed = firstFailed.load(); failed < lists.size()) {
+        std::vector<Token> rest(input.begin() + runs[failed], input.end());
+        auto tryParse = earleyParser(rest);
+        if (std::holds_alternative<CompilerError>(tryParse)) return tryParse;
+        lists[failed] = shifted(std::get<Branch>(std::get<Tree>(tryParse)).subtrees.at(0), runs[failed]);
+        lists.resize(failed + 1);
+    }
+
+    // BSTMTS is left-recursive, so a run's list starts with an empty BSTMTS where the runs before it go
+    Tree statements = std::move(*lists[0]);
+    for (std::size_t r = 1; r < lists.size(); r++) {
+        auto *first = &*lists[r];
+        while (!std::get<Branch>(*first).subtrees.empty()) first = &std::get<Branch>(*first).subtrees[0];
+        *first = std::move(statements);
+        statements = std::move(*lists[r]);
+    }
+    ArenaVector<Tree> start;
+    start.push_back(std::move(statements));
+    return Branch(grammar[0].lhs, 0, input.size(), std::move(start));
+}
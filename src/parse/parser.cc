@@ -1,3 +1,4 @@
+#include "parser.hh"
 #include "earley_algorithm.hh"
 #include <cassert>
 
@@ -8,9 +9,18 @@ std::vector<Token> stripInput(const std::vector<Token> &input) {
 }
 
 std::variant<CompilerError, Tree> earleyParser(const std::vector<Token> &originalInput) {
+    // the scanner leaves out whitespace and comments unless asked to keep them
+    if (std::none_of(originalInput.begin(), originalInput.end(), skipTokenPredicate)) {
+        Chart S(originalInput.size());
+        return resumeEarleyParser(originalInput, S, 0);
+    }
     const auto strippedInput = stripInput(originalInput);
-    Chart S = generateEarleyChart(strippedInput);
-    
+    Chart S(strippedInput.size());
+    return resumeEarleyParser(strippedInput, S, 0);
+}
+
+std::variant<CompilerError, Tree> resumeEarleyParser(const std::vector<Token> &strippedInput, Chart &S, std::size_t reusable) {
+    extendEarleyChart(S, strippedInput, reusable);
 
     auto &endState = S[strippedInput.size()];
     for (size_t i = 0; i < endState.size(); i++) {
@@ -4,5 +4,21 @@
 #include <std20c/error_message.hh>
 
 std::variant<CompilerError, Tree> earleyParser(const std::vector<Token> &input);
+// parses `input` as earleyParser does, on `threads` workers: the input is split into runs of whole
+//  top-level statements (where scanStatement would split the source), each parsed on its own and their
+//  statement lists joined into one. The whole input is parsed by earleyParser instead if it does not split
+//  cleanly, and the input from the first run that does not parse on, which finds the same error. Even on
+//  one thread this takes far less memory than earleyParser on long inputs, as every run gets its own chart
+std::variant<CompilerError, Tree> parallelEarleyParser(const std::vector<Token> &input, std::size_t threads);
+
+// every parse error in `input`, the first being `first`, what earleyParser reports: after each error the
+//  parse picks up again after the top-level statement the error is in, at the `;` or `}` ending it
+std::vector<CompilerError> recoverParseErrors(const std::vector<Token> &input, const CompilerError &first);
+
+class Chart;
+// parses `strippedInput` (no whitespace or comments) in `chart`, keeping its first `reusable` columns (see
+//  extendEarleyChart); the chart can be resumed the same way after the input changes
+std::variant<CompilerError, Tree> resumeEarleyParser(const std::vector<Token> &strippedInput, Chart &chart,
+                                                     std::size_t reusable);
 
 #endif
\ No newline at end of file
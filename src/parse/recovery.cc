@@ -0,0 +1,63 @@
+#include "parser.hh"
+#include "earley_algorithm.hh"
+#include <algorithm>
+
+// after an error the input is parsed on in windows of whole statements of about this many tokens, so the
+//  chart of each parse stays small however many errors there are
+constexpr std::size_t recoveryWindow = 4096;
+
+// the index after the top-level statement starting at `from`, which ends at a `;` or `}` outside any
+//  parentheses or braces and not followed by an else, as scanStatement splits the source; a `)` or `}`
+//  that closes nothing ends it too, and the input's end ends the last one
+std::size_t statementEnd(const std::vector<Token> &input, std::size_t from) {
+    std::size_t depth = 0;
+    for (std::size_t i = from; i < input.size(); i++) {
+        auto kind = input[i].kind;
+        if (kind == LPAREN || kind == LBPAREN) {
+            depth++;
+        } else if (kind == RPAREN || kind == RBPAREN) {
+            if (!depth) return i + 1;
+            depth--;
+        }
+        if (depth == 0 && (kind == SEMICOLON || kind == RBPAREN) && (i + 1 == input.size() || input[i + 1].kind != ELSE)) {
+            return i + 1;
+        }
+    }
+    return input.size();
+}
+
+// the index of the token `error` points at
+std::size_t tokenOf(const std::vector<Token> &input, const CompilerError &error) {
+    auto it = std::lower_bound(input.begin(), input.end(), error.errorPosition,
+                               [](const Token &token, const char *position) { return token.begin < position; });
+    return std::min<std::size_t>(it - input.begin(), input.size() - 1);
+}
+
+std::vector<CompilerError> recoverParseErrors(const std::vector<Token> &originalInput, const CompilerError &first) {
+    auto input = std::any_of(originalInput.begin(), originalInput.end(), skipTokenPredicate)
+        ? stripInput(originalInput) : originalInput;
+    std::vector<CompilerError> errors {first};
+    // the tokens before an error parse, so the statement ends found up to it are the ones of the program
+    auto resume = [&](std::size_t from, const CompilerError &error) {
+        auto bad = tokenOf(input, error);
+        while (from <= bad) from = statementEnd(input, from);
+        return from;
+    };
+    // a parse stops at the first token that cannot follow the ones before it, so a window reports the
+    //  error the rest of the input would, and one that parses cleanly leaves the next to start a statement
+    for (auto from = input.empty() ? 0 : resume(0, first); from < input.size();) {
+        auto to = from;
+        while (to < input.size() && to - from < recoveryWindow) to = statementEnd(input, to);
+        // the arena would keep the chart of every window until the compilation ends
+        HeapScope heap;
+        std::vector<Token> window(input.begin() + from, input.begin() + to);
+        auto tryParse = earleyParser(window);
+        if (std::holds_alternative<Tree>(tryParse)) {
+            from = to;
+        } else {
+            errors.push_back(std::get<CompilerError>(tryParse));
+            from = resume(from, errors.back());
+        }
+    }
+    return errors;
+}
@@ -1,7 +1,7 @@
 #ifndef STATE_HH
 #define STATE_HH
 #include <std20c/language.hh>
-#include <set>
+#include <std20c/arena.hh>
 
 struct State {
     struct BackPointer {
@@ -17,13 +17,13 @@ struct State {
     std::size_t dot;
     std::size_t left;
     std::size_t right;
-    std::set<BackPointer> backpointer;
+    ArenaSet<BackPointer> backpointer;
 
     State(const ProductionRule &p, std::size_t dot, std::size_t left, std::size_t right): p(p), dot(dot), left(left), right(right) {}
     bool operator==(const State &s) const {
         return &this->p == &s.p && this->dot == s.dot && this->left == s.right && this->left == s.right;
     }
-    void mergeBackPointers(std::set<BackPointer> o) {
+    void mergeBackPointers(const ArenaSet<BackPointer> &o) {
         backpointer.insert(o.begin(), o.end());
     }
 };
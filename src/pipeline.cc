@@ -0,0 +1,99 @@
+#include "pipeline.hh"
+#include <std20c/compilation.hh>
+#include <std20c/language.hh>
+#include "scan/tokenize.hh"
+#include "parse/parser.hh"
+#include "analysis/semantics.hh"
+#include "codegen/lower.hh"
+#include "instrument/phase.hh"
+#include <vector>
+
+std::variant<IR, CompilerError> compileIR(std::string_view code, size_t optimize, const UnrollCostModel &unroll,
+                                          OptimizationStats *stats, size_t parseThreads, std::vector<CompilerError> *errors) {
+    auto tryScan = [&] { PhaseScope phase("scan"); return maximalMunch(code); }();
+    if (std::holds_alternative<CompilerError>(tryScan)) {
+        if (errors) *errors = {std::get<CompilerError>(tryScan)};
+        return std::get<CompilerError>(tryScan);
+    }
+    auto tryParse = [&] {
+        PhaseScope phase("parse");
+        auto &tokens = std::get<std::vector<Token>>(tryScan);
+        return parseThreads ? parallelEarleyParser(tokens, parseThreads) : earleyParser(tokens);
+    }();
+    if (std::holds_alternative<CompilerError>(tryParse)) {
+        if (errors) {
+            PhaseScope phase("parse");
+            *errors = recoverParseErrors(std::get<std::vector<Token>>(tryScan), std::get<CompilerError>(tryParse));
+        }
+        return std::get<CompilerError>(tryParse);
+    }
+    auto &parseTree = std::get<Tree>(tryParse);
+    auto tryAnalyze = [&] { PhaseScope phase("semantics"); return generateSymbolTable(parseTree, errors); }();
+    if (std::holds_alternative<CompilerError>(tryAnalyze)) {
+        return std::get<CompilerError>(tryAnalyze);
+    }
+    auto tryCodeGen = [&] { PhaseScope phase("lower"); return generateIR(std::get<SymbolTable>(tryAnalyze), parseTree); }();
+    // in current implementation, generateIR is no fail
+
+    if (optimize) {
+        PhaseScope phase("optimize");
+        return optimizer(tryCodeGen, optimize, unroll, stats);
+    }
+    return tryCodeGen;
+}
+
+std::vector<CompilerError> streamIR(std::string_view code, const std::function<bool(const Instructions &)> &emit) {
+    // a scan error anywhere comes before any other, and the errors after the first are found in the whole
+    //  file, so the error a statement runs into is not necessarily the one to report
+    auto fail = [&] {
+        std::vector<CompilerError> errors;
+        compileIR(code, 0, UnrollCostModel(), nullptr, 0, &errors);
+        return errors;
+    };
+    StatementSemantics semantics;
+    LoweringCounters counters;
+    const char *begin = code.data(), *end = code.data() + code.size();
+    std::vector<Token> statement;
+    while (begin != end) {
+        std::optional<CompilerError> scanError;
+        {
+            PhaseScope phase("scan");
+            statement.clear();
+            scanStatement(begin, end, statement, scanError);
+        }
+        if (scanError) return fail();
+        if (statement.empty()) break;
+        auto tryParse = [&] { PhaseScope phase("parse"); return earleyParser(statement); }();
+        if (std::holds_alternative<CompilerError>(tryParse)) return fail();
+        auto &statements = std::get<Branch>(std::get<Tree>(tryParse)).subtrees.at(0);
+        semantics.symbolTable.tokenToVID.clear();    // the tokens of earlier statements are gone
+        if ([&] { PhaseScope phase("semantics"); return checkStatements(semantics, statements); }()) return fail();
+        IR ir;
+        {
+            PhaseScope phase("lower");
+            counters.nextRegister = semantics.context.idCounter;
+            generateStatementsIR(semantics.symbolTable, statements, counters, ir);
+            semantics.context.idCounter = counters.nextRegister;
+        }
+        if (!emit(ir.instructions)) break;
+    }
+    return {};
+}
+
+Diagnostic diagnosticOf(std::string_view code, const CompilerError &error) {
+    auto [line, column] = getLnCol(code, error.errorPosition);
+    return Diagnostic{error.type, static_cast<size_t>(error.errorPosition - code.data()), error.errorLength, line, column,
+                      error.errorMessage};
+}
+
+std::vector<Diagnostic> diagnosticsOf(std::string_view code, const std::vector<CompilerError> &errors) {
+    if (errors.size() == 1) return {diagnosticOf(code, errors.front())};
+    LineIndex lines(code);
+    std::vector<Diagnostic> diagnostics;
+    for (auto &error: errors) {
+        auto [line, column] = lines.lineAndColumn(error.errorPosition);
+        diagnostics.push_back(Diagnostic{error.type, static_cast<size_t>(error.errorPosition - code.data()),
+                                         error.errorLength, line, column, error.errorMessage});
+    }
+    return diagnostics;
+}
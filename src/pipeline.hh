@@ -0,0 +1,33 @@
+#ifndef PIPELINE_HH
+#define PIPELINE_HH
+#include <std20c/compile.hh>
+#include <std20c/error_message.hh>
+#include <std20c/ir.hh>
+#include "optimization/optimizer.hh"
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// scans, parses, checks, lowers and (at `optimize` > 0) optimizes `code`, each as a phase; errors point
+//  into `code`; what the optimizer did goes to `stats` if given; with `parseThreads`, the parse is
+//  parallelEarleyParser's on that many threads. On failure every error of the phase that failed goes to
+//  `errors` if given, the one returned first: all parse errors (see recoverParseErrors), else all
+//  semantic ones; the scanner stops at its first
+std::variant<IR, CompilerError> compileIR(std::string_view code, size_t optimize, const UnrollCostModel &unroll,
+                                          OptimizationStats *stats = nullptr, size_t parseThreads = 0,
+                                          std::vector<CompilerError> *errors = nullptr);
+// compiles `code` at -O0 a top-level statement at a time, handing the instructions of each statement to
+//  `emit` as soon as they are lowered, so memory does not grow with the length of the program (outside an
+//  ArenaScope, which would keep everything); temporaries are numbered among the variables, so registers
+//  differ from compileIR's; the errors are the ones compileIR(code, 0, ...) reports, none on success;
+//  false from `emit` stops
+std::vector<CompilerError> streamIR(std::string_view code, const std::function<bool(const Instructions &)> &emit);
+// an error of compileIR(code, ...) as the library reports it
+Diagnostic diagnosticOf(std::string_view code, const CompilerError &error);
+// many errors of compileIR(code, ...), finding their lines in one pass over `code`
+std::vector<Diagnostic> diagnosticsOf(std::string_view code, const std::vector<CompilerError> &errors);
+
+#endif
@@ -1,15 +1,84 @@
 #include "tokenize.hh"
-#include <optional>
+#include "trivia.hh"
 
-std::optional<Token> scanSingleToken(std::string::const_iterator &begin, const std::string::const_iterator &end) {
+const std::vector<KindToRegex> &tokenizationRules() {
+    static const std::vector<KindToRegex> rules {
+        {SPACE, "^\\s+"},
+        {COMMENT, "^\\/\\/.+"},
+        {SEMICOLON, "^;"},
+        {IF, "^if"},
+        {ELSE, "^else"},
+        {LPAREN, "^\\("},
+        {RPAREN, "^\\)"},
+        {LBPAREN, "^\\{"},
+        {RBPAREN, "^\\}"},
+        {WHILE, "^while"},
+        {TYPE, "(^Entity)|(^Number)|(^Vector)|(^String)"},
+        {NUMBER, "^\\d+(\\.\\d+)?"},
+        {STRING, "^\".*\""},
+        {ID, "^[a-zA-Z_][a-zA-Z0-9_]*"},
+        {ASSIGN, "^="},
+        {LOR, "^\\|\\|"},
+        {LAND, "^\\&\\&"},
+        {EQ, "^=="},
+        {NE, "^!="},
+        {LE, "^<="},
+        {LT, "^<"},
+        {GE, "^>="},
+        {GT, "^>"},
+        {PLUS, "^\\+"},
+        {MINUS, "^-"},
+        {STAR, "^\\*"},
+        {SLASH, "^\\/"},
+        {EXCLAIM, "^!"},
+        {PERIOD, "^\\."},
+        {COMMA, "^\\,"}
+    };
+    return rules;
+}
+
+// a comment at `begin`: `//` and at least one more character on the line, else the `/` is a SLASH
+bool isComment(const char *begin, const char *end) {
+    return end - begin > 2 && begin[0] == '/' && begin[1] == '/' && begin[2] != '\n' && begin[2] != '\r';
+}
+
+// the whitespace, comment or string token at `begin`, found by the kernels in trivia.hh rather than the
+//  regexes; no other rule matches as long where one of these does
+std::optional<Token> scanTrivia(const char *begin, const char *end) {
+    if (isWhitespace(*begin)) return Token(begin, skipWhitespace(begin, end) - begin, SPACE);
+    if (isComment(begin, end)) return Token(begin, findLineEnd(begin + 2, end) - begin, COMMENT);
+    if (*begin == '"') {
+        if (auto close = findStringEnd(begin + 1, end)) return Token(begin, close - begin, STRING);
+    }
+    return std::nullopt;
+}
+
+const char *skipTrivia(const char *begin, const char *end) {
+    while (begin != end) {
+        if (isWhitespace(*begin)) begin = skipWhitespace(begin, end);
+        else if (isComment(begin, end)) begin = findLineEnd(begin + 2, end);
+        else break;
+    }
+    return begin;
+}
+
+std::optional<Token> scanSingleToken(const char *&begin, const char *end) {
+    if (auto token = scanTrivia(begin, end)) {
+        begin += token->length;
+        return token;
+    }
     // longest match > order of appearence
     std::size_t longest_match = 0;
     std::optional<Token> result = std::optional<Token>();
-    for (auto &p : tokenizationRules) {
-        auto i = std::sregex_iterator(begin, end, p.regex);
-        if (i != std::sregex_iterator() && i->str().size() > longest_match) {
-            longest_match = i->str().size();
-            result = std::optional<Token>(Token(begin, i->str().length(), p.kind));
+    std::cmatch match;
+    for (auto &p : tokenizationRules()) {
+        // these only match where scanTrivia would have found them
+        if (p.kind == SPACE || p.kind == COMMENT || p.kind == STRING) continue;
+        // match_continuous: a rule only matches at `begin`, instead of being searched for in the rest of the source
+        if (std::regex_search(begin, end, match, p.regex, std::regex_constants::match_continuous)
+            && static_cast<std::size_t>(match.length()) > longest_match) {
+            longest_match = match.length();
+            result = std::optional<Token>(Token(begin, match.length(), p.kind));
         }
     }
     if (result.has_value()) {
@@ -18,11 +87,12 @@ std::optional<Token> scanSingleToken(std::string::const_iterator &begin, const s
     return result;
 }
 
-std::variant<CompilerError, std::vector<Token>> maximalMunch(const std::string &s) {
+std::variant<CompilerError, std::vector<Token>> maximalMunch(std::string_view s, bool keepTrivia) {
     std::vector<Token> v;
-    std::string::const_iterator begin = s.begin();
-    std::string::const_iterator end = s.end();
+    const char *begin = s.data();
+    const char *end = s.data() + s.size();
     while(begin != end) {
+        if (!keepTrivia && (begin = skipTrivia(begin, end)) == end) break;
         std::optional<Token> result = scanSingleToken(begin, end);
         if (result.has_value()) {
             v.push_back(result.value());
@@ -34,3 +104,31 @@ std::variant<CompilerError, std::vector<Token>> maximalMunch(const std::string &
 }
 
 
+
+std::optional<Token> peekSignificant(const char *&begin, const char *end, std::optional<CompilerError> &error) {
+    while ((begin = skipTrivia(begin, end)) != end) {
+        auto start = begin;
+        if (auto token = scanSingleToken(begin, end)) {
+            begin = start;
+            return token;
+        }
+        if (!error) error = CompilerError(CompilerError::Type::SCAN, begin, 1, "Unrecognized Token");
+        begin++;
+    }
+    return std::nullopt;
+}
+
+void scanStatement(const char *&begin, const char *end, std::vector<Token> &tokens, std::optional<CompilerError> &error) {
+    size_t depth = 0;
+    while (auto token = peekSignificant(begin, end, error)) {
+        begin += token->length;
+        tokens.push_back(*token);
+        auto kind = token->kind;
+        if (kind == LPAREN || kind == LBPAREN) depth++;
+        else if ((kind == RPAREN || kind == RBPAREN) && depth) depth--;
+        if (depth == 0 && (kind == SEMICOLON || kind == RBPAREN)) {
+            auto next = peekSignificant(begin, end, error);
+            if (!next || next->kind != ELSE) return;
+        }
+    }
+}
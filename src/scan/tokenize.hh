@@ -2,7 +2,19 @@
 #define TOKENIZE_HH
 #include <std20c/language.hh>
 #include <std20c/error_message.hh>
+#include <optional>
 
-std::variant<CompilerError, std::vector<Token>> maximalMunch(const std::string &s);
+// the tokens of `s`; whitespace and comments are skipped without becoming tokens unless `keepTrivia` asks
+//  for them, to look at what the scanner does
+std::variant<CompilerError, std::vector<Token>> maximalMunch(std::string_view s, bool keepTrivia = false);
+// the longest token starting at `begin`, which is moved past it; nullopt if none starts there
+std::optional<Token> scanSingleToken(const char *&begin, const char *end);
+// the next token that is not whitespace or a comment, with `begin` moved to its start; nullopt (and
+//  `begin` at `end`) if there is none. Characters no token starts at are skipped, the first becomes `error`
+std::optional<Token> peekSignificant(const char *&begin, const char *end, std::optional<CompilerError> &error);
+// scans the top-level statement at `begin` into `tokens`, without whitespace and comments: up to a `;` or
+//  `}` outside parentheses and braces that no `else` follows, or to `end`; moves `begin` to the first token
+//  of the next statement. Characters no token starts at are skipped, the first one becomes `error`
+void scanStatement(const char *&begin, const char *end, std::vector<Token> &tokens, std::optional<CompilerError> &error);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "trivia.hh"
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define AVX2_KERNEL
+#endif
+
+const char *skipWhitespaceScalar(const char *begin, const char *end) {
+    while (begin != end && isWhitespace(*begin)) begin++;
+    return begin;
+}
+const char *findLineEndScalar(const char *begin, const char *end) {
+    while (begin != end && *begin != '\n' && *begin != '\r') begin++;
+    return begin;
+}
+const char *findStringEndScalar(const char *begin, const char *end) {
+    const char *close = nullptr;
+    for (; begin != end && *begin != '\n' && *begin != '\r'; begin++) {
+        if (*begin == '"') close = begin + 1;
+    }
+    return close;
+}
+
+// the vector kernels test a block of bytes at once, turning it into a bit mask with a bit per byte, and
+//  leave the bytes after the last whole block to the scalar ones
+
+#if defined(__SSE2__)
+unsigned whitespaceMask(__m128i bytes) {
+    // bytes from 128 up compare as negative, so are not in \t..\r
+    auto control = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('\r' + 1)));
+    return _mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '))));
+}
+unsigned lineEndMask(__m128i bytes) {
+    return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+}
+
+const char *skipWhitespaceSSE2(const char *begin, const char *end) {
+    for (; end - begin >= 16; begin += 16) {
+        unsigned other = ~whitespaceMask(_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin))) & 0xffff;
+        if (other) return begin + __builtin_ctz(other);
+    }
+    return skipWhitespaceScalar(begin, end);
+}
+const char *findLineEndSSE2(const char *begin, const char *end) {
+    for (; end - begin >= 16; begin += 16) {
+        if (auto lineEnds = lineEndMask(_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin)))) {
+            return begin + __builtin_ctz(lineEnds);
+        }
+    }
+    return findLineEndScalar(begin, end);
+}
+const char *findStringEndSSE2(const char *begin, const char *end) {
+    const char *close = nullptr;
+    for (; end - begin >= 16; begin += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        unsigned quotes = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')));
+        auto lineEnds = lineEndMask(bytes);
+        if (lineEnds) quotes &= (lineEnds & -lineEnds) - 1;     // the ones before the first line end
+        if (quotes) close = begin + (31 - __builtin_clz(quotes)) + 1;
+        if (lineEnds) return close;
+    }
+    auto rest = findStringEndScalar(begin, end);
+    return rest ? rest : close;
+}
+#endif
+
+#if defined(AVX2_KERNEL)
+__attribute__((target("avx2"))) unsigned whitespaceMask(__m256i bytes) {
+    auto control = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('\t' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), bytes));
+    return _mm256_movemask_epi8(_mm256_or_si256(control, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '))));
+}
+__attribute__((target("avx2"))) unsigned lineEndMask(__m256i bytes) {
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))));
+}
+
+__attribute__((target("avx2"))) const char *skipWhitespaceAVX2(const char *begin, const char *end) {
+    for (; end - begin >= 32; begin += 32) {
+        unsigned other = ~whitespaceMask(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin)));
+        if (other) return begin + __builtin_ctz(other);
+    }
+    return skipWhitespaceScalar(begin, end);
+}
+__attribute__((target("avx2"))) const char *findLineEndAVX2(const char *begin, const char *end) {
+    for (; end - begin >= 32; begin += 32) {
+        if (auto lineEnds = lineEndMask(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin)))) {
+            return begin + __builtin_ctz(lineEnds);
+        }
+    }
+    return findLineEndScalar(begin, end);
+}
+__attribute__((target("avx2"))) const char *findStringEndAVX2(const char *begin, const char *end) {
+    const char *close = nullptr;
+    for (; end - begin >= 32; begin += 32) {
+        auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        unsigned quotes = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')));
+        auto lineEnds = lineEndMask(bytes);
+        if (lineEnds) quotes &= (lineEnds & -lineEnds) - 1;
+        if (quotes) close = begin + (31 - __builtin_clz(quotes)) + 1;
+        if (lineEnds) return close;
+    }
+    auto rest = findStringEndScalar(begin, end);
+    return rest ? rest : close;
+}
+#endif
+
+struct ScanKernel {
+    const char *name;
+    const char *(*skipWhitespace)(const char *, const char *);
+    const char *(*findLineEnd)(const char *, const char *);
+    const char *(*findStringEnd)(const char *, const char *);
+};
+
+// fastest first
+const ScanKernel scanKernels[] {
+#if defined(AVX2_KERNEL)
+    {"avx2", skipWhitespaceAVX2, findLineEndAVX2, findStringEndAVX2},
+#endif
+#if defined(__SSE2__)
+    {"sse2", skipWhitespaceSSE2, findLineEndSSE2, findStringEndSSE2},
+#endif
+    {"scalar", skipWhitespaceScalar, findLineEndScalar, findStringEndScalar},
+};
+
+bool supported(const ScanKernel &kernel) {
+#if defined(AVX2_KERNEL)
+    if (std::strcmp(kernel.name, "avx2") == 0) return __builtin_cpu_supports("avx2");
+#endif
+    return true;
+}
+
+const ScanKernel &chosenKernel() {
+    static const ScanKernel &chosen = []() -> const ScanKernel & {
+        auto wanted = std::getenv("STD20C_SCAN_KERNEL");
+        for (auto &kernel: scanKernels) {
+            if (wanted && std::strcmp(wanted, kernel.name) == 0 && supported(kernel)) return kernel;
+        }
+        for (auto &kernel: scanKernels) {
+            if (supported(kernel)) return kernel;
+        }
+        return scanKernels[std::size(scanKernels) - 1];
+    }();
+    return chosen;
+}
+
+const char *skipWhitespace(const char *begin, const char *end) {
+    return chosenKernel().skipWhitespace(begin, end);
+}
+const char *findLineEnd(const char *begin, const char *end) {
+    return chosenKernel().findLineEnd(begin, end);
+}
+const char *findStringEnd(const char *begin, const char *end) {
+    return chosenKernel().findStringEnd(begin, end);
+}
+const char *scanKernel() {
+    return chosenKernel().name;
+}
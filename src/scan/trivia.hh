@@ -0,0 +1,23 @@
+#ifndef TRIVIA_HH
+#define TRIVIA_HH
+
+// the scanner's loops over the bytes of whitespace, comments and string literals, run 32 or 16 bytes at a
+//  time with AVX2 or SSE2 when the CPU has them, else a byte at a time. The kernel is picked on first use;
+//  STD20C_SCAN_KERNEL=avx2|sse2|scalar picks one the CPU supports instead
+
+// what `\s` matches: space, \t, \n, \v, \f and \r
+inline bool isWhitespace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// the first byte in [begin, end) that is not whitespace, or `end`
+const char *skipWhitespace(const char *begin, const char *end);
+// the first \n or \r (what `.` does not match) in [begin, end), or `end`
+const char *findLineEnd(const char *begin, const char *end);
+// the end of a string literal whose opening quote is just before `begin`: past the last `"` before the
+//  line ends, as `".*"` matches; nullptr if the line has no other `"`
+const char *findStringEnd(const char *begin, const char *end);
+// the kernel in use: "avx2", "sse2" or "scalar"
+const char *scanKernel();
+
+#endif
@@ -4,24 +4,24 @@
 #include <tuple>
 #include <cassert>
 namespace {
-    template<std::size_t N, typename T, std::size_t... I>
-    auto vectorViewImpl(std::vector<T> &vec, std::index_sequence<I...>) {
+    template<std::size_t N, typename T, typename A, std::size_t... I>
+    auto vectorViewImpl(std::vector<T, A> &vec, std::index_sequence<I...>) {
         return std::tie(vec[I]...);
     }
-    template<std::size_t N, typename T, std::size_t... I>
-    auto vectorViewImpl(const std::vector<T> &vec, std::index_sequence<I...>) {
+    template<std::size_t N, typename T, typename A, std::size_t... I>
+    auto vectorViewImpl(const std::vector<T, A> &vec, std::index_sequence<I...>) {
         return std::tie(vec[I]...);
     }
 }
 
-template<std::size_t N, typename T>
-auto vectorView(std::vector<T> &vec) {
+template<std::size_t N, typename T, typename A>
+auto vectorView(std::vector<T, A> &vec) {
     assert((vec.size() >= N && "vectorView: vector has not enough elements"));
     return vectorViewImpl<N>(vec, std::make_index_sequence<N>{});
 }
 
-template<std::size_t N, typename T>
-auto vectorView(const std::vector<T> &vec) {
+template<std::size_t N, typename T, typename A>
+auto vectorView(const std::vector<T, A> &vec) {
     assert((vec.size() >= N && "vectorView: vector has not enough elements"));
     return vectorViewImpl<N>(vec, std::make_index_sequence<N>{});
 }
@@ -0,0 +1,239 @@
+#include "machine.hh"
+#include "../optimization/evaluate.hh"
+#include <sstream>
+#include <vector>
+
+using Operand = std::variant<VReg, std::string>;
+
+std::optional<VReg> registerOf(const std::string &word) {
+    if (word.size() < 2 || word[0] != '$' || word.find_first_not_of("0123456789", 1) != std::string::npos) return std::nullopt;
+    return std::stoul(word.substr(1));
+}
+
+std::vector<Operand> operandsOf(const std::string &text) {
+    std::vector<Operand> operands;
+    std::istringstream words(text);
+    std::string word;
+    while (words >> word) {
+        if (auto reg = registerOf(word)) operands.push_back(*reg);
+        else operands.push_back(word);
+    }
+    return operands;
+}
+
+std::variant<IR, ProgramError> loadProgram(const std::string &text) {
+    IR ir;
+    std::istringstream lines(text);
+    std::string line;
+    for (size_t number = 1; std::getline(lines, line); number++) {
+        if (line.empty() || line[0] == '#') continue;
+        auto equals = line.find(" = ");
+        if (line[0] != '$') {
+            auto operands = operandsOf(line);
+            if (operands.empty() || !std::holds_alternative<std::string>(operands[0])) {
+                return ProgramError{number, "expected an instruction"};
+            }
+            ir.instructions.push_back(GenericReadInstruction(operands));
+            continue;
+        }
+        auto lhs = equals == std::string::npos ? std::nullopt : registerOf(line.substr(0, equals));
+        if (!lhs) return ProgramError{number, "expected `$<slot> = <instruction>`"};
+        ir.virtualRegisters.insert(*lhs);
+        auto rhs = line.substr(equals + 3);
+        // `mov` takes the rest of the line, spaces included, as its immediate
+        if (rhs.rfind("mov ", 0) == 0 || rhs == "mov") {
+            auto value = rhs.size() > 4 ? rhs.substr(4) : "";
+            if (auto reg = registerOf(value)) ir.instructions.push_back(RegisterAssignInstruction(*lhs, *reg));
+            else ir.instructions.push_back(ImmediateAssignInstruction(*lhs, value));
+            continue;
+        }
+        auto operands = operandsOf(rhs);
+        if (operands.empty() || !std::holds_alternative<std::string>(operands[0])) {
+            return ProgramError{number, "expected an instruction after `=`"};
+        }
+        ir.instructions.push_back(GenericWriteInstruction(*lhs, operands));
+    }
+    return ir;
+}
+
+// the operand as a value of kind T, if it is one
+template<typename T>
+const T *operandOf(const std::vector<Value> &operands, size_t i) {
+    return i < operands.size() ? std::get_if<T>(&operands[i]) : nullptr;
+}
+
+std::optional<Constant> constantOf(const Value &value) {
+    if (auto n = std::get_if<double>(&value)) return *n;
+    if (auto s = std::get_if<std::string>(&value)) return *s;
+    if (auto v = std::get_if<ConstantVector>(&value)) return *v;
+    return std::nullopt;
+}
+
+// runs one builtin; nullopt if it fails, an empty value for builtins returning nothing
+std::optional<std::optional<Value>> callBuiltin(const std::string &opcode, const std::vector<Value> &operands, World &world) {
+    auto size = operands.size();
+    auto entity = [&](size_t i) { return operandOf<EntityRef>(operands, i); };
+    auto vector = [&](size_t i) { return operandOf<ConstantVector>(operands, i); };
+    auto number = [&](size_t i) { return operandOf<double>(operands, i); };
+    auto string = [&](size_t i) { return operandOf<std::string>(operands, i); };
+    using Result = std::optional<std::optional<Value>>;
+    auto value = [](auto result) -> Result {
+        if (!result) return std::nullopt;
+        return std::optional<Value>(*result);
+    };
+    auto done = [](bool succeeded) -> Result {
+        if (!succeeded) return std::nullopt;
+        return std::optional<Value>();
+    };
+
+    // sifyd's extra detail is not modelled
+    if ((opcode == "sify" || opcode == "sifyd") && size == 1) return std::optional<Value>(textOf(operands[0]));
+    if (opcode == "print" && size == 1) {
+        world.print(textOf(operands[0]));
+        return std::optional<Value>();
+    }
+    if (opcode == "findent" && size == 2 && vector(0) && number(1)) return value(world.findEntity(*vector(0), *number(1)));
+    if (opcode == "entpos" && size == 1 && entity(0)) return value(world.entityPosition(*entity(0)));
+    if (opcode == "entvel" && size == 1 && entity(0)) return value(world.entityVelocity(*entity(0)));
+    if (opcode == "entfacing" && size == 1 && entity(0)) return value(world.entityFacing(*entity(0)));
+    if (opcode == "checkblock" && size == 2 && vector(0) && string(1)) return value(world.checkBlock(*vector(0), *string(1)));
+    if (opcode == "accelent" && size == 2 && entity(0) && vector(1)) return done(world.accelerateEntity(*entity(0), *vector(1)));
+    if (opcode == "damageent" && size == 2 && entity(0) && number(1)) return done(world.damageEntity(*entity(0), *number(1)));
+    if (opcode == "mountent" && size == 2 && entity(0) && entity(1)) return done(world.mountEntity(*entity(0), *entity(1)));
+    if (opcode == "fireballpwr" && size == 2 && entity(0) && number(1)) return done(world.setFireballPower(*entity(0), *number(1)));
+    if (opcode == "explode" && size == 2 && vector(0) && number(1)) return done(world.explode(*vector(0), *number(1)));
+    if (opcode == "placeblock" && size == 2 && vector(0) && string(1)) return done(world.placeBlock(*vector(0), *string(1)));
+    if (opcode == "destroyblock" && size == 1 && vector(0)) return done(world.destroyBlock(*vector(0)));
+    if (opcode == "lightning" && size == 1 && vector(0)) return done(world.lightning(*vector(0)));
+    if (opcode == "summon" && size == 2 && vector(0) && string(1)) return value(world.summon(*vector(0), *string(1)));
+    if (opcode == "wait" && size == 1 && number(0)) {
+        world.wait(*number(0));
+        return std::optional<Value>();
+    }
+
+    std::vector<Constant> constants;
+    for (auto &operand: operands) {
+        auto constant = constantOf(operand);
+        if (!constant) return std::nullopt;
+        constants.push_back(*constant);
+    }
+    auto result = applyBuiltin(opcode, constants);
+    if (!result) return std::nullopt;
+    return std::optional<Value>(std::visit([](auto &&v) -> Value { return v; }, *result));
+}
+
+// whether a jump is taken; nullopt if its operands cannot be compared
+std::optional<bool> compareValues(const std::string &opcode, const Value &left, const Value &right) {
+    auto l = constantOf(left), r = constantOf(right);
+    if (l && r) return compareConstants(opcode, *l, *r);
+    auto a = std::get_if<EntityRef>(&left), b = std::get_if<EntityRef>(&right);
+    if (!a || !b) return std::nullopt;
+    if (opcode == "jmpe") return *a == *b;
+    if (opcode == "jmpne") return *a != *b;
+    return std::nullopt;
+}
+
+Execution execute(const IR &ir, World &world, size_t limit) {
+    Execution execution;
+    auto &stats = execution.stats;
+    std::map<std::string, size_t> labels;
+    for (size_t i = 0; i < ir.instructions.size(); i++) {
+        auto read = std::get_if<GenericReadInstruction>(&ir.instructions[i]);
+        if (read && read->instruction.size() == 2 && std::get<std::string>(read->instruction[0]) == "label"
+            && std::holds_alternative<std::string>(read->instruction[1])) {
+            labels.emplace(std::get<std::string>(read->instruction[1]), i);
+        }
+    }
+
+    std::vector<std::optional<Value>> slots{Value(EntityRef{0}), Value(EntityRef{1})};
+    std::string failure;
+    auto valueOf = [&](const Operand &operand) -> std::optional<Value> {
+        if (std::holds_alternative<std::string>(operand)) {
+            return std::visit([](auto &&v) -> Value { return v; }, constantOfImmediate(std::get<std::string>(operand)));
+        }
+        auto reg = std::get<VReg>(operand);
+        if (reg >= slots.size() || !slots[reg]) {
+            failure = "read of empty slot $" + std::to_string(reg);
+            return std::nullopt;
+        }
+        return slots[reg];
+    };
+    auto write = [&](VReg reg, Value value) {
+        if (reg >= slots.size()) slots.resize(reg + 1);
+        slots[reg] = std::move(value);
+        stats.peakSlots = std::max(stats.peakSlots, reg + 1);
+    };
+
+    for (size_t pc = 0; pc < ir.instructions.size();) {
+        auto &ins = ir.instructions[pc++];
+        if (auto read = std::get_if<GenericReadInstruction>(&ins); read && std::get<std::string>(read->instruction[0]) == "label") {
+            continue;
+        }
+        if (stats.instructions == limit) {
+            execution.abort = "instruction limit of " + std::to_string(limit) + " reached";
+            return execution;
+        }
+        stats.instructions++;
+
+        if (auto assign = std::get_if<ImmediateAssignInstruction>(&ins)) {
+            stats.opcodes["mov"]++;
+            write(assign->lhs, *valueOf(assign->value));
+            continue;
+        }
+        if (auto assign = std::get_if<RegisterAssignInstruction>(&ins)) {
+            stats.opcodes["mov"]++;
+            auto value = valueOf(assign->rhs);
+            if (!value) break;
+            write(assign->lhs, *value);
+            continue;
+        }
+
+        auto &list = std::holds_alternative<GenericWriteInstruction>(ins) ? std::get<GenericWriteInstruction>(ins).rhs
+                                                                          : std::get<GenericReadInstruction>(ins).instruction;
+        auto &opcode = std::get<std::string>(list[0]);
+        stats.opcodes[opcode]++;
+        std::vector<Value> operands;
+        for (size_t i = 1; i < list.size(); i++) {
+            if (opcode.rfind("jmp", 0) == 0 && i == 1) continue;
+            auto value = valueOf(list[i]);
+            if (!value) break;
+            operands.push_back(*value);
+        }
+        if (!failure.empty()) break;
+
+        if (opcode.rfind("jmp", 0) == 0) {
+            auto label = list.size() == 4 ? std::get_if<std::string>(&list[1]) : nullptr;
+            if (!label || !labels.count(*label)) {
+                failure = "`" + opcode + "` to an unknown label";
+                break;
+            }
+            auto taken = compareValues(opcode, operands[0], operands[1]);
+            if (!taken) {
+                failure = "`" + opcode + "` cannot compare " + textOf(operands[0]) + " and " + textOf(operands[1]);
+                break;
+            }
+            if (*taken) {
+                stats.jumpsTaken++;
+                pc = labels.at(*label);
+            }
+            continue;
+        }
+
+        stats.builtinCalls++;
+        auto result = callBuiltin(opcode, operands, world);
+        if (!result) {
+            failure = "`" + opcode + "` failed";
+            for (auto &operand: operands) failure += " " + textOf(operand);
+            break;
+        }
+        if (auto assign = std::get_if<GenericWriteInstruction>(&ins)) {
+            if (!*result) {
+                failure = "`" + opcode + "` returns nothing";
+                break;
+            }
+            write(assign->lhs, **result);
+        }
+    }
+    if (!failure.empty()) execution.abort = failure;
+    return execution;
+}
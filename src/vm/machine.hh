@@ -0,0 +1,35 @@
+#ifndef MACHINE_HH
+#define MACHINE_HH
+#include "world.hh"
+#include <std20c/ir.hh>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <variant>
+
+struct ProgramError {
+    std::size_t line;
+    std::string message;
+};
+
+// reads emitted `#lang std20` text (one instruction per line, see operator<<(ostream, IR)) back into IR
+std::variant<IR, ProgramError> loadProgram(const std::string &text);
+
+struct ExecutionStats {
+    std::size_t instructions = 0;               // executed, labels not counted
+    std::size_t jumpsTaken = 0;
+    std::size_t builtinCalls = 0;               // executed instructions other than mov and jumps
+    std::size_t peakSlots = reservedRegisters;  // slots up to the highest one written
+    std::map<std::string, std::size_t> opcodes; // executions per opcode
+};
+struct Execution {
+    ExecutionStats stats;
+    std::optional<std::string> abort;           // why the spell stopped before its end
+};
+
+// runs a program the way std20 does, with SELF and TARGET as entities 0 and 1 of the world,
+//  stopping after `limit` instructions
+Execution execute(const IR &, World &, std::size_t limit);
+
+#endif
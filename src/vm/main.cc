@@ -0,0 +1,91 @@
+#include "machine.hh"
+#include "world.hh"
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <variant>
+
+std::optional<std::string> readFile(const std::string &name) {
+    std::ifstream file(name);
+    if (!file) return std::nullopt;
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// runs compiled std20 text against a scripted world: prints what the spell did to the world, then
+//  (on stderr) how much work it took
+int main(int argc, char* argv[]) {
+    std::string executable = argv[0];
+
+    std::optional<std::string> infile;
+    std::optional<std::string> worldfile;
+    size_t limit = 10000000;
+    bool profile = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        if (str == "--world" || str == "--limit") {
+            if (i+1 >= argc) {
+                std::cerr << executable << ": missing argument after `" << str << "`\n";
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (str == "--world") {
+                worldfile = value;
+            } else if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << executable << ": invalid instruction count in `" << value << "`\n";
+                return 1;
+            } else {
+                limit = std::stoul(value);
+            }
+        } else if (str == "--profile") {
+            profile = true;
+        } else if (!infile.has_value()) {
+            infile = str;
+        } else {
+            std::cerr << executable << ": unrecognized command-line option `" << str << "`\n";
+            return 1;
+        }
+    }
+    if (!infile.has_value()) {
+        std::cerr << "usage: " << executable << " program [--world script] [--limit N] [--profile]\n";
+        return 1;
+    }
+
+    auto text = readFile(*infile);
+    if (!text) {
+        std::cerr << executable << ": cannot find " << *infile << ": No such file or directory\n";
+        return 1;
+    }
+    auto tryLoad = loadProgram(*text);
+    if (std::holds_alternative<ProgramError>(tryLoad)) {
+        auto &error = std::get<ProgramError>(tryLoad);
+        std::cerr << *infile << ":" << error.line << ": " << error.message << "\n";
+        return 1;
+    }
+
+    auto script = worldfile ? readFile(*worldfile) : std::string();
+    if (!script) {
+        std::cerr << executable << ": cannot find " << *worldfile << ": No such file or directory\n";
+        return 1;
+    }
+    auto tryWorld = loadWorldScript(*script);
+    if (std::holds_alternative<WorldScriptError>(tryWorld)) {
+        auto &error = std::get<WorldScriptError>(tryWorld);
+        std::cerr << *worldfile << ":" << error.line << ": " << error.message << "\n";
+        return 1;
+    }
+    auto &world = std::get<ScriptedWorld>(tryWorld);
+
+    auto execution = execute(std::get<IR>(tryLoad), world, limit);
+    for (auto &event: world.transcript) std::cout << event << "\n";
+    if (execution.abort) std::cout << "abort " << *execution.abort << "\n";
+
+    auto &stats = execution.stats;
+    std::cerr << "executed " << stats.instructions << " instructions, " << stats.jumpsTaken << " jumps taken, "
+              << stats.builtinCalls << " builtin calls, peak " << stats.peakSlots << " slots\n";
+    if (profile) {
+        for (auto &[opcode, count]: stats.opcodes) std::cerr << "  " << opcode << " " << count << "\n";
+    }
+    return execution.abort ? 2 : 0;
+}
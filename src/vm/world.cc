@@ -0,0 +1,177 @@
+#include "world.hh"
+#include "../optimization/evaluate.hh"
+#include <cmath>
+#include <sstream>
+
+std::string textOf(const Value &value) {
+    if (std::holds_alternative<EntityRef>(value)) return "entity " + std::to_string(std::get<EntityRef>(value).id);
+    if (std::holds_alternative<double>(value)) return sifyNumber(std::get<double>(value));
+    if (std::holds_alternative<std::string>(value)) return std::get<std::string>(value);
+    auto &v = std::get<ConstantVector>(value);
+    return "(" + sifyNumber(v[0]) + ", " + sifyNumber(v[1]) + ", " + sifyNumber(v[2]) + ")";
+}
+
+ConstantVector blockOf(const ConstantVector &position) {
+    return {std::floor(position[0]), std::floor(position[1]), std::floor(position[2])};
+}
+
+bool isAlive(const std::vector<ScriptedEntity> &entities, EntityRef entity) {
+    return entity.id < entities.size() && entities[entity.id].alive;
+}
+
+std::optional<EntityRef> ScriptedWorld::findEntity(const ConstantVector &position, double radius) {
+    // the closest living entity in range, the first one listed on ties
+    std::optional<EntityRef> found;
+    double closest = radius;
+    for (size_t id = 0; id < entities.size(); id++) {
+        if (!entities[id].alive) continue;
+        auto &p = entities[id].position;
+        auto distance = std::sqrt((p[0] - position[0]) * (p[0] - position[0]) + (p[1] - position[1]) * (p[1] - position[1])
+                                  + (p[2] - position[2]) * (p[2] - position[2]));
+        if (distance <= closest && (!found || distance < closest)) {
+            found = EntityRef{id};
+            closest = distance;
+        }
+    }
+    return found;
+}
+
+std::optional<ConstantVector> ScriptedWorld::entityPosition(EntityRef entity) {
+    if (!isAlive(entities, entity)) return std::nullopt;
+    return entities[entity.id].position;
+}
+
+std::optional<ConstantVector> ScriptedWorld::entityVelocity(EntityRef entity) {
+    if (!isAlive(entities, entity)) return std::nullopt;
+    return entities[entity.id].velocity;
+}
+
+std::optional<ConstantVector> ScriptedWorld::entityFacing(EntityRef entity) {
+    if (!isAlive(entities, entity)) return std::nullopt;
+    return entities[entity.id].facing;
+}
+
+std::optional<double> ScriptedWorld::checkBlock(const ConstantVector &position, const std::string &block) {
+    auto at = blockOf(position);
+    std::string found = at[1] < groundLevel ? "stone" : "air";
+    for (auto &placed: blocks) {
+        if (placed.position == at) found = placed.block;
+    }
+    return found == block ? 1.0 : 0.0;
+}
+
+bool ScriptedWorld::accelerateEntity(EntityRef entity, const ConstantVector &velocity) {
+    if (!isAlive(entities, entity)) return false;
+    auto &v = entities[entity.id].velocity;
+    for (size_t i = 0; i < 3; i++) v[i] += velocity[i];
+    transcript.push_back("accelent " + textOf(entity) + " " + textOf(velocity));
+    return true;
+}
+
+bool ScriptedWorld::damageEntity(EntityRef entity, double amount) {
+    if (!isAlive(entities, entity)) return false;
+    transcript.push_back("damageent " + textOf(entity) + " " + textOf(amount));
+    return true;
+}
+
+bool ScriptedWorld::mountEntity(EntityRef rider, EntityRef vehicle) {
+    if (!isAlive(entities, rider) || !isAlive(entities, vehicle)) return false;
+    transcript.push_back("mountent " + textOf(rider) + " " + textOf(vehicle));
+    return true;
+}
+
+bool ScriptedWorld::setFireballPower(EntityRef entity, double power) {
+    if (!isAlive(entities, entity)) return false;
+    transcript.push_back("fireballpwr " + textOf(entity) + " " + textOf(power));
+    return true;
+}
+
+bool ScriptedWorld::explode(const ConstantVector &position, double power) {
+    transcript.push_back("explode " + textOf(position) + " " + textOf(power));
+    return true;
+}
+
+bool ScriptedWorld::placeBlock(const ConstantVector &position, const std::string &block) {
+    blocks.push_back({blockOf(position), block});
+    transcript.push_back("placeblock " + textOf(position) + " " + block);
+    return true;
+}
+
+bool ScriptedWorld::destroyBlock(const ConstantVector &position) {
+    blocks.push_back({blockOf(position), "air"});
+    transcript.push_back("destroyblock " + textOf(position));
+    return true;
+}
+
+bool ScriptedWorld::lightning(const ConstantVector &position) {
+    transcript.push_back("lightning " + textOf(position));
+    return true;
+}
+
+std::optional<EntityRef> ScriptedWorld::summon(const ConstantVector &position, const std::string &kind) {
+    EntityRef entity{entities.size()};
+    entities.push_back({kind, position, {0, 0, 0}, {0, 0, 1}});
+    transcript.push_back("summon " + textOf(position) + " " + kind + " -> " + textOf(entity));
+    return entity;
+}
+
+void ScriptedWorld::wait(double ticks) {
+    transcript.push_back("wait " + textOf(ticks));
+    if (!(ticks > 0)) return;
+    for (auto &entity: entities) {
+        for (size_t i = 0; i < 3; i++) entity.position[i] += entity.velocity[i] * ticks;
+    }
+}
+
+void ScriptedWorld::print(const std::string &text) {
+    transcript.push_back("print " + text);
+}
+
+std::optional<ConstantVector> readVector(std::istringstream &words) {
+    std::string x, y, z;
+    if (!(words >> x >> y >> z)) return std::nullopt;
+    auto px = parseNumber(x), py = parseNumber(y), pz = parseNumber(z);
+    if (!px || !py || !pz) return std::nullopt;
+    return ConstantVector{*px, *py, *pz};
+}
+
+std::variant<ScriptedWorld, WorldScriptError> loadWorldScript(const std::string &script) {
+    ScriptedWorld world;
+    std::istringstream lines(script);
+    std::string line;
+    for (size_t number = 1; std::getline(lines, line); number++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword)) continue;
+        if (keyword == "entity") {
+            ScriptedEntity entity{"", {0, 0, 0}, {0, 0, 0}, {0, 0, 1}};
+            auto position = (words >> entity.kind) ? readVector(words) : std::nullopt;
+            if (!position) return WorldScriptError{number, "expected `entity <kind> <x> <y> <z>`"};
+            entity.position = *position;
+            std::string option;
+            while (words >> option) {
+                auto vector = readVector(words);
+                if (option == "facing" && vector) entity.facing = *vector;
+                else if (option == "velocity" && vector) entity.velocity = *vector;
+                else return WorldScriptError{number, "expected `facing <x> <y> <z>` or `velocity <x> <y> <z>`"};
+            }
+            world.entities.push_back(entity);
+        } else if (keyword == "block") {
+            auto position = readVector(words);
+            std::string block, rest;
+            if (!position || !(words >> block) || words >> rest) return WorldScriptError{number, "expected `block <x> <y> <z> <name>`"};
+            world.blocks.push_back({blockOf(*position), block});
+        } else if (keyword == "ground") {
+            std::string level, rest;
+            auto y = (words >> level) ? parseNumber(level) : std::nullopt;
+            if (!y || words >> rest) return WorldScriptError{number, "expected `ground <y>`"};
+            world.groundLevel = *y;
+        } else {
+            return WorldScriptError{number, "unknown keyword `" + keyword + "`"};
+        }
+    }
+    if (world.entities.size() < 1) world.entities.push_back({"player", {0, 64, 0}, {0, 0, 0}, {0, 0, 1}});
+    if (world.entities.size() < 2) world.entities.push_back({"zombie", {5, 64, 5}, {0, 0, 0}, {1, 0, 0}});
+    return world;
+}
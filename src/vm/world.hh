@@ -0,0 +1,95 @@
+#ifndef WORLD_HH
+#define WORLD_HH
+#include "../optimization/constant.hh"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+// an entity of the world by index; SELF and TARGET are entities 0 and 1
+struct EntityRef {
+    std::size_t id;
+    bool operator==(const EntityRef &other) const { return id == other.id; }
+    bool operator!=(const EntityRef &other) const { return id != other.id; }
+};
+// a std20 value at run time
+using Value = std::variant<double, std::string, ConstantVector, EntityRef>;
+
+// std20's text for a value (`sify`); entities are written as `entity <id>`
+std::string textOf(const Value &);
+
+// what a spell can see of and do to the game; nullopt/false makes the builtin fail, which aborts the spell
+struct World {
+    virtual ~World() = default;
+    virtual std::optional<EntityRef> findEntity(const ConstantVector &position, double radius) = 0;
+    virtual std::optional<ConstantVector> entityPosition(EntityRef) = 0;
+    virtual std::optional<ConstantVector> entityVelocity(EntityRef) = 0;
+    virtual std::optional<ConstantVector> entityFacing(EntityRef) = 0;
+    virtual std::optional<double> checkBlock(const ConstantVector &position, const std::string &block) = 0;
+    virtual bool accelerateEntity(EntityRef, const ConstantVector &velocity) = 0;
+    virtual bool damageEntity(EntityRef, double amount) = 0;
+    virtual bool mountEntity(EntityRef rider, EntityRef vehicle) = 0;
+    virtual bool setFireballPower(EntityRef, double power) = 0;
+    virtual bool explode(const ConstantVector &position, double power) = 0;
+    virtual bool placeBlock(const ConstantVector &position, const std::string &block) = 0;
+    virtual bool destroyBlock(const ConstantVector &position) = 0;
+    virtual bool lightning(const ConstantVector &position) = 0;
+    virtual std::optional<EntityRef> summon(const ConstantVector &position, const std::string &kind) = 0;
+    virtual void wait(double ticks) = 0;
+    virtual void print(const std::string &text) = 0;
+};
+
+struct ScriptedEntity {
+    std::string kind;
+    ConstantVector position;
+    ConstantVector velocity;
+    ConstantVector facing;
+    bool alive = true;
+};
+struct ScriptedBlock {
+    ConstantVector position;    // block coordinates (whole numbers)
+    std::string block;
+};
+
+// a world set up from a script (see loadWorldScript) that records everything done to it, one line per
+//  event in `transcript`, so that runs of differently optimized code can be compared;
+//  entities move by their velocity every tick waited, blocks are air unless placed or below `groundLevel`
+struct ScriptedWorld: World {
+    std::vector<ScriptedEntity> entities;
+    std::vector<ScriptedBlock> blocks;
+    double groundLevel = 64;
+    std::vector<std::string> transcript;
+
+    std::optional<EntityRef> findEntity(const ConstantVector &position, double radius) override;
+    std::optional<ConstantVector> entityPosition(EntityRef) override;
+    std::optional<ConstantVector> entityVelocity(EntityRef) override;
+    std::optional<ConstantVector> entityFacing(EntityRef) override;
+    std::optional<double> checkBlock(const ConstantVector &position, const std::string &block) override;
+    bool accelerateEntity(EntityRef, const ConstantVector &velocity) override;
+    bool damageEntity(EntityRef, double amount) override;
+    bool mountEntity(EntityRef rider, EntityRef vehicle) override;
+    bool setFireballPower(EntityRef, double power) override;
+    bool explode(const ConstantVector &position, double power) override;
+    bool placeBlock(const ConstantVector &position, const std::string &block) override;
+    bool destroyBlock(const ConstantVector &position) override;
+    bool lightning(const ConstantVector &position) override;
+    std::optional<EntityRef> summon(const ConstantVector &position, const std::string &kind) override;
+    void wait(double ticks) override;
+    void print(const std::string &text) override;
+};
+
+struct WorldScriptError {
+    std::size_t line;
+    std::string message;
+};
+
+// a world from lines of
+//   entity <kind> <x> <y> <z> [facing <x> <y> <z>] [velocity <x> <y> <z>]
+//   block <x> <y> <z> <name>
+//   ground <y>
+//  with `#` comments; the first two entities are SELF and TARGET, which default to a player at
+//  (0, 64, 0) facing south and a zombie at (5, 64, 5) facing east
+std::variant<ScriptedWorld, WorldScriptError> loadWorldScript(const std::string &script);
+
+#endif